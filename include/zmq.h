@@ -139,6 +139,8 @@ ZMQ_EXPORT size_t zmq_msg_size (zmq_msg_t *msg);
 
 ZMQ_EXPORT void *zmq_init (int app_threads, int io_threads, int flags);
 ZMQ_EXPORT int zmq_term (void *context);
+ZMQ_EXPORT int zmq_setctxopt (void *context, int option, const void *optval,
+    size_t optvallen);
 
 ////////////////////////////////////////////////////////////////////////////////
 //  0MQ socket definition.
@@ -179,6 +181,34 @@ ZMQ_EXPORT int zmq_term (void *context);
 #define ZMQ_MCAST_LOOP 10
 #define ZMQ_SNDBUF 11
 #define ZMQ_RCVBUF 12
+#define ZMQ_HWM_BYTES 13
+#define ZMQ_LWM_BYTES 14
+#define ZMQ_SUBSCRIBE_EXACT 15
+#define ZMQ_UNSUBSCRIBE_EXACT 16
+#define ZMQ_BALANCE 17
+#define ZMQ_BALANCE_KEY_SIZE 18
+#define ZMQ_QUANTUM 19
+#define ZMQ_RCVSPIN 20
+#define ZMQ_IN_BATCH_SIZE 21
+#define ZMQ_OUT_BATCH_SIZE 22
+#define ZMQ_INBOUND_POLL_RATE 23
+#define ZMQ_COMMAND_DELAY 24
+#define ZMQ_BACKLOG 25
+
+//  Read-only socket statistics, available via zmq_getsockopt.
+#define ZMQ_MSGS_SENT 26
+#define ZMQ_MSGS_RECEIVED 27
+#define ZMQ_BYTES_SENT 28
+#define ZMQ_BYTES_RECEIVED 29
+#define ZMQ_HWM_STALLS 30
+#define ZMQ_DROPS 31
+#define ZMQ_RECONNECTS 32
+#define ZMQ_QUEUED 33
+#define ZMQ_MAX_QUEUED 34
+
+#define ZMQ_BALANCE_ROUND_ROBIN 0
+#define ZMQ_BALANCE_LEAST_QUEUED 1
+#define ZMQ_BALANCE_KEY_HASH 2
 
 #define ZMQ_NOBLOCK 1
 #define ZMQ_MORE 2
@@ -187,10 +217,14 @@ ZMQ_EXPORT void *zmq_socket (void *context, int type);
 ZMQ_EXPORT int zmq_close (void *s);
 ZMQ_EXPORT int zmq_setsockopt (void *s, int option, const void *optval,
     size_t optvallen); 
+ZMQ_EXPORT int zmq_getsockopt (void *s, int option, void *optval,
+    size_t *optvallen);
 ZMQ_EXPORT int zmq_bind (void *s, const char *addr);
 ZMQ_EXPORT int zmq_connect (void *s, const char *addr);
 ZMQ_EXPORT int zmq_send (void *s, zmq_msg_t *msg, int flags);
 ZMQ_EXPORT int zmq_recv (void *s, zmq_msg_t *msg, int flags);
+ZMQ_EXPORT int zmq_sendv (void *s, zmq_msg_t *msgs, size_t count, int flags);
+ZMQ_EXPORT int zmq_recvv (void *s, zmq_msg_t *msgs, size_t count, int flags);
 
 ////////////////////////////////////////////////////////////////////////////////
 //  I/O multiplexing.
@@ -214,6 +248,14 @@ typedef struct
 
 ZMQ_EXPORT int zmq_poll (zmq_pollitem_t *items, int nitems, long timeout);
 
+ZMQ_EXPORT void *zmq_poller_new ();
+ZMQ_EXPORT int zmq_poller_close (void *poller);
+ZMQ_EXPORT int zmq_poller_add (void *poller, zmq_pollitem_t *item);
+ZMQ_EXPORT int zmq_poller_modify (void *poller, zmq_pollitem_t *item);
+ZMQ_EXPORT int zmq_poller_remove (void *poller, zmq_pollitem_t *item);
+ZMQ_EXPORT int zmq_poller_wait (void *poller, zmq_pollitem_t *items,
+    int nitems, long timeout);
+
 ////////////////////////////////////////////////////////////////////////////////
 //  Experimental.
 ////////////////////////////////////////////////////////////////////////////////
@@ -238,6 +280,12 @@ ZMQ_EXPORT void *zmq_stopwatch_start ();
 //  the stopwatch was started.
 ZMQ_EXPORT unsigned long zmq_stopwatch_stop (void *watch_);
 
+//  Returns the number of microseconds elapsed since an arbitrary point in
+//  the past, with sub-microsecond resolution where the platform provides it.
+//  The clock is monotonic. Unlike the stopwatch it doesn't allocate memory,
+//  so it's cheap enough to timestamp individual messages.
+ZMQ_EXPORT double zmq_clock ();
+
 //  Sleeps for specified number of seconds.
 ZMQ_EXPORT void zmq_sleep (int seconds_);
 
@@ -0,0 +1,186 @@
+/*
+    Copyright (c) 2007-2010 iMatix Corporation
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the Lesser GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    Lesser GNU General Public License for more details.
+
+    You should have received a copy of the Lesser GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "../include/zmq.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+//  Measures the cost of allocating and deallocating message buffers via
+//  zmq_msg_init_size/zmq_msg_close. Two scenarios are measured: buffers
+//  deallocated by the thread that allocated them and buffers deallocated
+//  by a different thread, the way messages received by an I/O thread are
+//  closed by an application thread. In the latter case messages are
+//  passed to the other thread in windows of the specified size.
+//
+//  To compare different allocation strategies, run the test against
+//  the respective builds of the library.
+
+static int message_size;
+static int message_count;
+static int window_size;
+
+//  Two windows of messages. While the worker closes messages in one of
+//  them, the main thread fills in the other one.
+static zmq_msg_t *windows [2];
+static int filled [2];
+static pthread_mutex_t window_sync = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+
+static void *close_msgs (void *arg_)
+{
+    int w = 0;
+    int n;
+    int i;
+
+    while (1) {
+        pthread_mutex_lock (&window_sync);
+        while (filled [w] < 0)
+            pthread_cond_wait (&cond, &window_sync);
+        n = filled [w];
+        pthread_mutex_unlock (&window_sync);
+
+        for (i = 0; i != n; i++)
+            zmq_msg_close (&windows [w][i]);
+
+        pthread_mutex_lock (&window_sync);
+        filled [w] = -1;
+        pthread_cond_broadcast (&cond);
+        pthread_mutex_unlock (&window_sync);
+
+        //  Empty window means end of the test.
+        if (n == 0)
+            return NULL;
+        w = 1 - w;
+    }
+}
+
+static void print_result (const char *name_, unsigned long elapsed_)
+{
+    unsigned long throughput;
+
+    if (elapsed_ == 0)
+        elapsed_ = 1;
+    throughput = (unsigned long)
+        ((double) message_count / (double) elapsed_ * 1000000);
+    printf ("%s: %d [ops/s]\n", name_, (int) throughput);
+}
+
+int main (int argc, char *argv [])
+{
+    int rc;
+    int i;
+    int w;
+    int n;
+    int sent;
+    void *watch;
+    unsigned long elapsed;
+    zmq_msg_t msg;
+    pthread_t worker;
+
+    if (argc != 4) {
+        printf ("usage: alloc_thr <message-size> <message-count> "
+            "<window-size>\n");
+        return 1;
+    }
+    message_size = atoi (argv [1]);
+    message_count = atoi (argv [2]);
+    window_size = atoi (argv [3]);
+
+    windows [0] = (zmq_msg_t*) malloc (sizeof (zmq_msg_t) * window_size);
+    windows [1] = (zmq_msg_t*) malloc (sizeof (zmq_msg_t) * window_size);
+    if (!windows [0] || !windows [1]) {
+        printf ("out of memory\n");
+        return -1;
+    }
+    filled [0] = -1;
+    filled [1] = -1;
+
+    printf ("message size: %d [B]\n", (int) message_size);
+    printf ("message count: %d\n", (int) message_count);
+    printf ("window size: %d\n", (int) window_size);
+
+    //  Same thread, allocations interleaved with deallocations.
+    watch = zmq_stopwatch_start ();
+    for (i = 0; i != message_count; i++) {
+        rc = zmq_msg_init_size (&msg, message_size);
+        if (rc != 0) {
+            printf ("error in zmq_msg_init_size: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+        memset (zmq_msg_data (&msg), 0, 1);
+        zmq_msg_close (&msg);
+    }
+    print_result ("same thread", zmq_stopwatch_stop (watch));
+
+    //  Buffers allocated by this thread and deallocated by the worker.
+    rc = pthread_create (&worker, NULL, close_msgs, NULL);
+    if (rc != 0) {
+        printf ("error in pthread_create\n");
+        return -1;
+    }
+    watch = zmq_stopwatch_start ();
+    w = 0;
+    sent = 0;
+    while (1) {
+        n = message_count - sent;
+        if (n > window_size)
+            n = window_size;
+
+        //  Wait till the worker is done with the window.
+        pthread_mutex_lock (&window_sync);
+        while (filled [w] >= 0)
+            pthread_cond_wait (&cond, &window_sync);
+        pthread_mutex_unlock (&window_sync);
+
+        for (i = 0; i != n; i++) {
+            rc = zmq_msg_init_size (&windows [w][i], message_size);
+            if (rc != 0) {
+                printf ("error in zmq_msg_init_size: %s\n",
+                    zmq_strerror (errno));
+                return -1;
+            }
+            memset (zmq_msg_data (&windows [w][i]), 0, 1);
+        }
+
+        pthread_mutex_lock (&window_sync);
+        filled [w] = n;
+        pthread_cond_broadcast (&cond);
+        pthread_mutex_unlock (&window_sync);
+
+        if (n == 0)
+            break;
+        sent += n;
+        w = 1 - w;
+    }
+    rc = pthread_join (worker, NULL);
+    if (rc != 0) {
+        printf ("error in pthread_join\n");
+        return -1;
+    }
+    elapsed = zmq_stopwatch_stop (watch);
+    print_result ("cross thread", elapsed);
+
+    free (windows [0]);
+    free (windows [1]);
+
+    return 0;
+}
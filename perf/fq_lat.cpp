@@ -0,0 +1,251 @@
+/*
+    Copyright (c) 2007-2010 iMatix Corporation
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the Lesser GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    Lesser GNU General Public License for more details.
+
+    You should have received a copy of the Lesser GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "../include/zmq.h"
+#include "../src/stdint.hpp"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <algorithm>
+
+//  Measures the latency of small messages competing with bulk messages for
+//  a single UPSTREAM socket. One peer sends bulk messages as fast as the
+//  consumer processes them, the other one sends small messages, each of
+//  them carrying a stopwatch started when the message was sent. Processing
+//  of a message costs time proportional to its size. Run the test with
+//  quantum of zero to get the latency with plain round robin and with
+//  a non-zero quantum to get the latency with deficit round robin. Note that
+//  the latency includes the time the consumer takes to notice that the small
+//  peer has sent a message after a pause; while the consumer is busy, incoming
+//  commands are processed only once per 'inbound_poll_rate' messages.
+
+static const char *address = "inproc://fq_lat";
+static void *ctx;
+static int bulk_size;
+static int message_count;
+static uint32_t checksum;
+
+static void *send_bulk (void *arg_)
+{
+    int rc;
+    int i;
+    void *s;
+    zmq_msg_t msg;
+    uint64_t hwm = 64;
+    uint64_t lwm = 32;
+
+    s = zmq_socket (ctx, ZMQ_DOWNSTREAM);
+    if (!s) {
+        printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
+        exit (1);
+    }
+    //  Limit the memory used by queued messages, yet keep enough of them
+    //  queued so that there's always a bulk message waiting.
+    rc = zmq_setsockopt (s, ZMQ_HWM, &hwm, sizeof (hwm));
+    if (rc == 0)
+        rc = zmq_setsockopt (s, ZMQ_LWM, &lwm, sizeof (lwm));
+    if (rc == 0)
+        rc = zmq_connect (s, address);
+    if (rc != 0) {
+        printf ("error in zmq_connect: %s\n", zmq_strerror (errno));
+        exit (1);
+    }
+
+    for (i = 0; i != message_count; i++) {
+        rc = zmq_msg_init_size (&msg, bulk_size);
+        if (rc != 0) {
+            printf ("error in zmq_msg_init_size: %s\n", zmq_strerror (errno));
+            exit (1);
+        }
+        memset (zmq_msg_data (&msg), i, bulk_size);
+        rc = zmq_send (s, &msg, 0);
+        if (rc != 0) {
+            printf ("error in zmq_send: %s\n", zmq_strerror (errno));
+            exit (1);
+        }
+        zmq_msg_close (&msg);
+    }
+
+    zmq_close (s);
+    return NULL;
+}
+
+static void *send_small (void *arg_)
+{
+    int rc;
+    int i;
+    void *s;
+    void *watch;
+    zmq_msg_t msg;
+
+    s = zmq_socket (ctx, ZMQ_DOWNSTREAM);
+    if (!s) {
+        printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
+        exit (1);
+    }
+    rc = zmq_connect (s, address);
+    if (rc != 0) {
+        printf ("error in zmq_connect: %s\n", zmq_strerror (errno));
+        exit (1);
+    }
+
+    //  Let the bulk messages queue up first.
+    zmq_sleep (1);
+
+    for (i = 0; i != message_count; i++) {
+        rc = zmq_msg_init_size (&msg, sizeof (void*));
+        if (rc != 0) {
+            printf ("error in zmq_msg_init_size: %s\n", zmq_strerror (errno));
+            exit (1);
+        }
+        watch = zmq_stopwatch_start ();
+        memcpy (zmq_msg_data (&msg), &watch, sizeof (void*));
+        rc = zmq_send (s, &msg, 0);
+        if (rc != 0) {
+            printf ("error in zmq_send: %s\n", zmq_strerror (errno));
+            exit (1);
+        }
+        zmq_msg_close (&msg);
+    }
+
+    zmq_close (s);
+    return NULL;
+}
+
+int main (int argc, char *argv [])
+{
+    int rc;
+    int i;
+    void *s;
+    void *watch;
+    zmq_msg_t msg;
+    uint64_t quantum;
+    unsigned long *latencies;
+    int small_count;
+    double total;
+    unsigned char *data;
+    size_t size;
+    pthread_t bulk_thread;
+    pthread_t small_thread;
+
+    if (argc != 4) {
+        printf ("usage: fq_lat <quantum> <bulk-message-size> "
+            "<message-count>\n");
+        return 1;
+    }
+    quantum = (uint64_t) atoi (argv [1]);
+    bulk_size = atoi (argv [2]);
+    message_count = atoi (argv [3]);
+    if (bulk_size <= (int) sizeof (void*) || message_count <= 0) {
+        printf ("bulk messages have to be larger than small ones\n");
+        return 1;
+    }
+
+    latencies = (unsigned long*) malloc (sizeof (unsigned long) *
+        message_count);
+    if (!latencies) {
+        printf ("out of memory\n");
+        return -1;
+    }
+
+    ctx = zmq_init (3, 1, 0);
+    if (!ctx) {
+        printf ("error in zmq_init: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    s = zmq_socket (ctx, ZMQ_UPSTREAM);
+    if (!s) {
+        printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+    rc = zmq_setsockopt (s, ZMQ_QUANTUM, &quantum, sizeof (quantum));
+    if (rc != 0) {
+        printf ("error in zmq_setsockopt: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+    rc = zmq_bind (s, address);
+    if (rc != 0) {
+        printf ("error in zmq_bind: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    rc = pthread_create (&bulk_thread, NULL, send_bulk, NULL);
+    if (rc == 0)
+        rc = pthread_create (&small_thread, NULL, send_small, NULL);
+    if (rc != 0) {
+        printf ("error in pthread_create\n");
+        return -1;
+    }
+
+    rc = zmq_msg_init (&msg);
+    if (rc != 0) {
+        printf ("error in zmq_msg_init: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    small_count = 0;
+    for (i = 0; i != message_count * 2; i++) {
+        rc = zmq_recv (s, &msg, 0);
+        if (rc != 0) {
+            printf ("error in zmq_recv: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+        data = (unsigned char*) zmq_msg_data (&msg);
+        size = zmq_msg_size (&msg);
+
+        //  Small message. Stop its stopwatch.
+        if (size == sizeof (void*)) {
+            memcpy (&watch, data, sizeof (void*));
+            latencies [small_count++] = zmq_stopwatch_stop (watch);
+            continue;
+        }
+
+        //  Bulk message. Process it byte by byte. Each step depends on
+        //  the previous one so that the loop can't be vectorised.
+        for (size_t j = 0; j != size; j++)
+            checksum = checksum * 33 + data [j];
+    }
+    zmq_msg_close (&msg);
+
+    pthread_join (bulk_thread, NULL);
+    pthread_join (small_thread, NULL);
+
+    total = 0;
+    for (i = 0; i != small_count; i++)
+        total += latencies [i];
+    std::sort (latencies, latencies + small_count);
+
+    printf ("quantum: %d [B]\n", (int) quantum);
+    printf ("bulk message size: %d [B]\n", bulk_size);
+    printf ("message count: %d\n", message_count);
+    printf ("average small message latency: %.3f [us]\n",
+        total / small_count);
+    printf ("99th percentile small message latency: %d [us]\n",
+        (int) latencies [(small_count - 1) * 99 / 100]);
+    printf ("maximum small message latency: %d [us]\n",
+        (int) latencies [small_count - 1]);
+
+    free (latencies);
+    zmq_close (s);
+    zmq_term (ctx);
+
+    return 0;
+}
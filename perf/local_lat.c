@@ -20,6 +20,7 @@
 #include "../include/zmq.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 
 int main (int argc, char *argv [])
 {
@@ -31,15 +32,17 @@ int main (int argc, char *argv [])
     int rc;
     int i;
     zmq_msg_t msg;
+    uint64_t spin;
 
-    if (argc != 4) {
+    if (argc != 4 && argc != 5) {
         printf ("usage: local_lat <bind-to> <message-size> "
-            "<roundtrip-count>\n");
+            "<roundtrip-count> [<spin-time>]\n");
         return 1;
     }
     bind_to = argv [1];
     message_size = atoi (argv [2]);
     roundtrip_count = atoi (argv [3]);
+    spin = argc == 5 ? (uint64_t) atoi (argv [4]) : 0;
 
     ctx = zmq_init (1, 1, 0);
     if (!ctx) {
@@ -53,6 +56,12 @@ int main (int argc, char *argv [])
         return -1;
     }
 
+    rc = zmq_setsockopt (s, ZMQ_RCVSPIN, &spin, sizeof (spin));
+    if (rc != 0) {
+        printf ("error in zmq_setsockopt: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
     rc = zmq_bind (s, bind_to);
     if (rc != 0) {
         printf ("error in zmq_bind: %s\n", zmq_strerror (errno));
@@ -0,0 +1,173 @@
+/*
+    Copyright (c) 2007-2010 iMatix Corporation
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the Lesser GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    Lesser GNU General Public License for more details.
+
+    You should have received a copy of the Lesser GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "../include/zmq.h"
+#include "../src/prefix_tree.hpp"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+
+//  Measures the rate of adding, matching and removing subscriptions in
+//  the subscription trie, as well as the memory it uses, for 1k, 100k
+//  and 1M subscriptions. Subscriptions are random alphanumeric strings
+//  16 to 32 bytes long. Half of the messages checked match a subscription,
+//  the other half are random strings.
+
+//  Memory allocated via operator new is counted so that the memory used
+//  by the trie can be reported. Each block is prefixed by its size.
+static size_t allocated;
+
+void *operator new (size_t size_)
+{
+    size_t *block = (size_t*) malloc (sizeof (size_t) + size_);
+    if (!block)
+        throw std::bad_alloc ();
+    *block = size_;
+    allocated += size_;
+    return block + 1;
+}
+
+void operator delete (void *ptr_) throw ()
+{
+    if (!ptr_)
+        return;
+    size_t *block = ((size_t*) ptr_) - 1;
+    allocated -= *block;
+    free (block);
+}
+
+static const int max_size = 40;
+
+static void fill (unsigned char *data_, int size_)
+{
+    static const char chars [] = "abcdefghijklmnopqrstuvwxyz0123456789";
+    int i;
+    for (i = 0; i != size_; i++)
+        data_ [i] = chars [rand () % (sizeof chars - 1)];
+}
+
+static void print_result (const char *name_, int count_,
+    unsigned long elapsed_)
+{
+    unsigned long throughput;
+
+    if (elapsed_ == 0)
+        elapsed_ = 1;
+    throughput = (unsigned long)
+        ((double) count_ / (double) elapsed_ * 1000000);
+    printf ("%s: %d [ops/s]\n", name_, (int) throughput);
+}
+
+static int run (int subscription_count_, int message_count_)
+{
+    unsigned char *subscriptions;
+    int *sizes;
+    unsigned char *messages;
+    int *message_sizes;
+    zmq::prefix_tree_t *tree;
+    size_t base;
+    void *watch;
+    int matched;
+    int i;
+
+    subscriptions = (unsigned char*) malloc (subscription_count_ * max_size);
+    sizes = (int*) malloc (subscription_count_ * sizeof (int));
+    messages = (unsigned char*) malloc (message_count_ * max_size);
+    message_sizes = (int*) malloc (message_count_ * sizeof (int));
+    if (!subscriptions || !sizes || !messages || !message_sizes) {
+        printf ("out of memory\n");
+        return -1;
+    }
+
+    for (i = 0; i != subscription_count_; i++) {
+        sizes [i] = 16 + rand () % 17;
+        fill (subscriptions + i * max_size, sizes [i]);
+    }
+    for (i = 0; i != message_count_; i++) {
+        if (i % 2) {
+            int s = rand () % subscription_count_;
+            memcpy (messages + i * max_size, subscriptions + s * max_size,
+                sizes [s]);
+            message_sizes [i] = sizes [s] + rand () % (max_size - sizes [s]);
+            fill (messages + i * max_size + sizes [s],
+                message_sizes [i] - sizes [s]);
+        }
+        else {
+            message_sizes [i] = 16 + rand () % 17;
+            fill (messages + i * max_size, message_sizes [i]);
+        }
+    }
+
+    printf ("subscription count: %d\n", subscription_count_);
+
+    base = allocated;
+    tree = new zmq::prefix_tree_t;
+
+    watch = zmq_stopwatch_start ();
+    for (i = 0; i != subscription_count_; i++)
+        tree->add (subscriptions + i * max_size, sizes [i]);
+    print_result ("add", subscription_count_, zmq_stopwatch_stop (watch));
+
+    printf ("memory: %d [B]\n", (int) (allocated - base));
+    printf ("memory per subscription: %.1f [B]\n",
+        (double) (allocated - base) / subscription_count_);
+
+    matched = 0;
+    watch = zmq_stopwatch_start ();
+    for (i = 0; i != message_count_; i++)
+        if (tree->check (messages + i * max_size, message_sizes [i]))
+            matched++;
+    print_result ("check", message_count_, zmq_stopwatch_stop (watch));
+    printf ("matched: %d of %d\n", matched, message_count_);
+
+    watch = zmq_stopwatch_start ();
+    for (i = 0; i != subscription_count_; i++)
+        if (!tree->rm (subscriptions + i * max_size, sizes [i])) {
+            printf ("subscription not found\n");
+            return -1;
+        }
+    print_result ("rm", subscription_count_, zmq_stopwatch_stop (watch));
+
+    delete tree;
+    free (subscriptions);
+    free (sizes);
+    free (messages);
+    free (message_sizes);
+
+    return 0;
+}
+
+int main (int argc, char *argv [])
+{
+    int message_count;
+
+    if (argc != 2) {
+        printf ("usage: prefix_tree_thr <message-count>\n");
+        return 1;
+    }
+    message_count = atoi (argv [1]);
+
+    if (run (1000, message_count) != 0 ||
+          run (100000, message_count) != 0 ||
+          run (1000000, message_count) != 0)
+        return -1;
+
+    return 0;
+}
@@ -21,6 +21,67 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+
+//  Round trips are recorded in nanoseconds into a histogram with the layout
+//  of HDR histogram: the range of values is split into powers of two and
+//  each of them is split into SUB_BUCKETS linear buckets. Thus, every value
+//  is recorded with relative precision of 1/SUB_BUCKETS while the histogram
+//  covers all 32-bit values in a few kilobytes of memory.
+#define SUB_BUCKET_BITS 6
+#define SUB_BUCKETS (1 << SUB_BUCKET_BITS)
+#define BUCKET_COUNT ((32 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS)
+
+static unsigned long histogram [BUCKET_COUNT];
+
+static int bucket_index (uint32_t value_)
+{
+    int magnitude = 0;
+    while ((value_ >> magnitude) >= 2 * SUB_BUCKETS)
+        magnitude++;
+    return magnitude * SUB_BUCKETS + (int) (value_ >> magnitude);
+}
+
+//  Returns the highest value that falls into the bucket.
+static uint64_t bucket_value (int index_)
+{
+    int magnitude;
+    uint64_t sub_bucket;
+
+    if (index_ < 2 * SUB_BUCKETS)
+        return index_;
+    magnitude = index_ / SUB_BUCKETS - 1;
+    sub_bucket = index_ % SUB_BUCKETS + SUB_BUCKETS;
+    return ((sub_bucket + 1) << magnitude) - 1;
+}
+
+//  Returns the value below or at which the specified percentage of the
+//  recorded values lie.
+static uint64_t percentile (double percentage_, unsigned long count_)
+{
+    unsigned long target;
+    unsigned long total;
+    int i;
+
+    target = (unsigned long) (percentage_ / 100 * count_ + 0.5);
+    if (target < 1)
+        target = 1;
+    total = 0;
+    for (i = 0; i != BUCKET_COUNT; i++) {
+        total += histogram [i];
+        if (total >= target)
+            break;
+    }
+    return bucket_value (i);
+}
+
+static void print_percentile (const char *name_, double percentage_,
+    unsigned long count_)
+{
+    //  Latency is half of the round trip.
+    printf ("%s latency: %.3f [us]\n", name_,
+        (double) percentile (percentage_, count_) / 2000);
+}
 
 int main (int argc, char *argv [])
 {
@@ -32,18 +93,38 @@ int main (int argc, char *argv [])
     int rc;
     int i;
     zmq_msg_t msg;
-    void *watch;
-    unsigned long elapsed;
+    uint64_t spin;
+    const char *samples_file;
+    uint32_t *samples;
+    FILE *f;
+    double start;
+    double sent;
+    double received;
+    double roundtrip;
+    uint32_t value;
+    uint32_t max_value;
     double latency;
 
-    if (argc != 4) {
+    if (argc < 4 || argc > 6) {
         printf ("usage: remote_lat <connect-to> <message-size> "
-            "<roundtrip-count>\n");
+            "<roundtrip-count> [<spin-time> [<samples-file>]]\n");
         return 1;
     }
     connect_to = argv [1];
     message_size = atoi (argv [2]);
     roundtrip_count = atoi (argv [3]);
+    spin = argc >= 5 ? (uint64_t) atoi (argv [4]) : 0;
+    samples_file = argc == 6 ? argv [5] : NULL;
+
+    //  Raw samples are kept only if they are to be dumped.
+    samples = NULL;
+    if (samples_file) {
+        samples = (uint32_t*) malloc (sizeof (uint32_t) * roundtrip_count);
+        if (!samples) {
+            printf ("out of memory\n");
+            return -1;
+        }
+    }
 
     ctx = zmq_init (1, 1, 0);
     if (!ctx) {
@@ -57,6 +138,12 @@ int main (int argc, char *argv [])
         return -1;
     }
 
+    rc = zmq_setsockopt (s, ZMQ_RCVSPIN, &spin, sizeof (spin));
+    if (rc != 0) {
+        printf ("error in zmq_setsockopt: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
     rc = zmq_connect (s, connect_to);
     if (rc != 0) {
         printf ("error in zmq_connect: %s\n", zmq_strerror (errno));
@@ -70,7 +157,9 @@ int main (int argc, char *argv [])
     }
     memset (zmq_msg_data (&msg), 0, message_size);
 
-    watch = zmq_stopwatch_start ();
+    max_value = 0;
+    start = zmq_clock ();
+    sent = start;
 
     for (i = 0; i != roundtrip_count; i++) {
         rc = zmq_send (s, &msg, 0);
@@ -83,13 +172,26 @@ int main (int argc, char *argv [])
             printf ("error in zmq_recv: %s\n", zmq_strerror (errno));
             return -1;
         }
+
+        //  The time the reply was received at is the time the next request
+        //  is sent at, so there's a single clock reading per round trip.
+        received = zmq_clock ();
+        roundtrip = (received - sent) * 1000;
+        sent = received;
+        value = roundtrip < 4294967295.0 ? (uint32_t) roundtrip : 0xffffffff;
+        histogram [bucket_index (value)]++;
+        if (value > max_value)
+            max_value = value;
+        if (samples)
+            samples [i] = value;
+
         if (zmq_msg_size (&msg) != message_size) {
             printf ("message of incorrect size received\n");
             return -1;
         }
     }
 
-    elapsed = zmq_stopwatch_stop (watch);
+    latency = (sent - start) / (roundtrip_count * 2);
 
     rc = zmq_msg_close (&msg);
     if (rc != 0) {
@@ -97,11 +199,28 @@ int main (int argc, char *argv [])
         return -1;
     }
 
-    latency = (double) elapsed / (roundtrip_count * 2);
-
     printf ("message size: %d [B]\n", (int) message_size);
     printf ("roundtrip count: %d\n", (int) roundtrip_count);
     printf ("average latency: %.3f [us]\n", (double) latency);
+    print_percentile ("median", 50, roundtrip_count);
+    print_percentile ("99th percentile", 99, roundtrip_count);
+    print_percentile ("99.9th percentile", 99.9, roundtrip_count);
+    print_percentile ("99.99th percentile", 99.99, roundtrip_count);
+    printf ("maximum latency: %.3f [us]\n", (double) max_value / 2000);
+
+    //  Dump the latencies of individual round trips, one per line, so that
+    //  they can be plotted or compared between runs.
+    if (samples) {
+        f = fopen (samples_file, "w");
+        if (!f) {
+            printf ("cannot open %s\n", samples_file);
+            return -1;
+        }
+        for (i = 0; i != roundtrip_count; i++)
+            fprintf (f, "%.3f\n", (double) samples [i] / 2000);
+        fclose (f);
+        free (samples);
+    }
 
     rc = zmq_close (s);
     if (rc != 0) {
@@ -0,0 +1,191 @@
+/*
+    Copyright (c) 2007-2010 iMatix Corporation
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the Lesser GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    Lesser GNU General Public License for more details.
+
+    You should have received a copy of the Lesser GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "../include/zmq.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+//  Measures the throughput of the swap. Messages are sent via an inproc
+//  pipe with a small high water mark, so nearly all of them are spilled
+//  to the swap file. Afterwards, they are received, which refills the pipe
+//  from the swap file.
+
+int main (int argc, char *argv [])
+{
+    int message_size;
+    int message_count;
+    uint64_t hwm;
+    int64_t swap;
+    void *ctx;
+    void *in;
+    void *out;
+    int rc;
+    int i;
+    zmq_msg_t msg;
+    void *watch;
+    unsigned long elapsed;
+    unsigned long throughput;
+    double megabits;
+
+    if (argc != 4) {
+        printf ("usage: swap_thr <message-size> <message-count> <hwm>\n");
+        return 1;
+    }
+    message_size = atoi (argv [1]);
+    message_count = atoi (argv [2]);
+    hwm = (uint64_t) atoi (argv [3]);
+
+    //  Each message occupies 9 bytes of header in the swap file.
+    swap = (int64_t) message_count * (message_size + 9);
+
+    ctx = zmq_init (1, 1, 0);
+    if (!ctx) {
+        printf ("error in zmq_init: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    in = zmq_socket (ctx, ZMQ_UPSTREAM);
+    if (!in) {
+        printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    rc = zmq_bind (in, "inproc://swap_thr");
+    if (rc != 0) {
+        printf ("error in zmq_bind: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    out = zmq_socket (ctx, ZMQ_DOWNSTREAM);
+    if (!out) {
+        printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    rc = zmq_setsockopt (out, ZMQ_HWM, &hwm, sizeof (hwm));
+    if (rc != 0) {
+        printf ("error in zmq_setsockopt: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    rc = zmq_setsockopt (out, ZMQ_SWAP, &swap, sizeof (swap));
+    if (rc != 0) {
+        printf ("error in zmq_setsockopt: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    rc = zmq_connect (out, "inproc://swap_thr");
+    if (rc != 0) {
+        printf ("error in zmq_connect: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    //  Spill the messages to the swap.
+    watch = zmq_stopwatch_start ();
+
+    for (i = 0; i != message_count; i++) {
+        rc = zmq_msg_init_size (&msg, message_size);
+        if (rc != 0) {
+            printf ("error in zmq_msg_init_size: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+        rc = zmq_send (out, &msg, 0);
+        if (rc != 0) {
+            printf ("error in zmq_send: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+        rc = zmq_msg_close (&msg);
+        if (rc != 0) {
+            printf ("error in zmq_msg_close: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+    }
+
+    elapsed = zmq_stopwatch_stop (watch);
+    if (elapsed == 0)
+        elapsed = 1;
+
+    throughput = (unsigned long)
+        ((double) message_count / (double) elapsed * 1000000);
+    megabits = (double) (throughput * message_size * 8) / 1000000;
+
+    printf ("message size: %d [B]\n", (int) message_size);
+    printf ("message count: %d\n", (int) message_count);
+    printf ("spill throughput: %d [msg/s]\n", (int) throughput);
+    printf ("spill throughput: %.3f [Mb/s]\n", (double) megabits);
+
+    //  Read the messages back from the swap.
+    rc = zmq_msg_init (&msg);
+    if (rc != 0) {
+        printf ("error in zmq_msg_init: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    watch = zmq_stopwatch_start ();
+
+    for (i = 0; i != message_count; i++) {
+        rc = zmq_recv (in, &msg, 0);
+        if (rc != 0) {
+            printf ("error in zmq_recv: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+        if (zmq_msg_size (&msg) != message_size) {
+            printf ("message of incorrect size received\n");
+            return -1;
+        }
+    }
+
+    elapsed = zmq_stopwatch_stop (watch);
+    if (elapsed == 0)
+        elapsed = 1;
+
+    rc = zmq_msg_close (&msg);
+    if (rc != 0) {
+        printf ("error in zmq_msg_close: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    throughput = (unsigned long)
+        ((double) message_count / (double) elapsed * 1000000);
+    megabits = (double) (throughput * message_size * 8) / 1000000;
+
+    printf ("refill throughput: %d [msg/s]\n", (int) throughput);
+    printf ("refill throughput: %.3f [Mb/s]\n", (double) megabits);
+
+    rc = zmq_close (out);
+    if (rc != 0) {
+        printf ("error in zmq_close: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    rc = zmq_close (in);
+    if (rc != 0) {
+        printf ("error in zmq_close: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    rc = zmq_term (ctx);
+    if (rc != 0) {
+        printf ("error in zmq_term: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    return 0;
+}
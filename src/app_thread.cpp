@@ -35,6 +35,7 @@
 
 #include "app_thread.hpp"
 #include "dispatcher.hpp"
+#include "mailbox.hpp"
 #include "fd_signaler.hpp"
 #include "ypollset.hpp"
 #include "err.hpp"
@@ -72,11 +73,16 @@ zmq::app_thread_t::app_thread_t (dispatcher_t *dispatcher_, int thread_slot_,
         signaler = new (std::nothrow) ypollset_t;
         zmq_assert (signaler);
     }
+
+    mailbox = new (std::nothrow) mailbox_t (signaler);
+    zmq_assert (mailbox);
 }
 
 zmq::app_thread_t::~app_thread_t ()
 {
     zmq_assert (sockets.empty ());
+    zmq_assert (mailbox);
+    delete mailbox;
     zmq_assert (signaler);
     delete signaler;
 }
@@ -86,11 +92,18 @@ zmq::i_signaler *zmq::app_thread_t::get_signaler ()
     return signaler;
 }
 
-void zmq::app_thread_t::process_commands (bool block_, bool throttle_)
+zmq::mailbox_t *zmq::app_thread_t::get_mailbox ()
+{
+    return mailbox;
+}
+
+void zmq::app_thread_t::process_commands (bool block_, uint64_t throttle_)
 {
-    uint64_t signals;
-    if (block_)
-        signals = signaler->poll ();
+    bool signaled;
+    if (block_) {
+        signaler->poll ();
+        signaled = true;
+    }
     else {
 
 #if defined ZMQ_DELAY_COMMANDS
@@ -116,27 +129,37 @@ void zmq::app_thread_t::process_commands (bool block_, bool throttle_)
 
             //  Check whether certain time have elapsed since last command
             //  processing.
-            if (current_time - last_processing_time <= max_command_delay)
+            if (current_time - last_processing_time <= throttle_)
                 return;
             last_processing_time = current_time;
         }
 #endif
 
         //  Check whether there are any commands pending for this thread.
-        signals = signaler->check ();
+        //  If the mailbox is drained there's no need to ask the signaler,
+        //  which saves a syscall in the case of fd_signaler. A stale signal
+        //  left behind will be consumed by the next blocking wait or by
+        //  process_signaled_commands.
+        signaled = mailbox->has_pending () && signaler->check ();
     }
 
-    if (signals) {
+    if (signaled) {
 
-        //  Traverse all the possible sources of commands and process
-        //  all the commands from all of them.
-        for (int i = 0; i != thread_slot_count (); i++) {
-            if (signals & (uint64_t (1) << i)) {
-                command_t cmd;
-                while (dispatcher->read (i, get_thread_slot (), &cmd))
-                    cmd.destination->process_command (cmd);
-            }
-        }
+        //  Process all the commands available in the mailbox.
+        command_t cmd;
+        while (mailbox->recv (&cmd))
+            cmd.destination->process_command (cmd);
+    }
+}
+
+void zmq::app_thread_t::process_signaled_commands ()
+{
+    if (signaler->check ()) {
+
+        //  Process all the commands available in the mailbox.
+        command_t cmd;
+        while (mailbox->recv (&cmd))
+            cmd.destination->process_command (cmd);
     }
 }
 
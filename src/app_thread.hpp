@@ -41,11 +41,20 @@ namespace zmq
         //  Returns signaler associated with this application thread.
         struct i_signaler *get_signaler ();
 
+        //  Returns mailbox associated with this application thread.
+        class mailbox_t *get_mailbox ();
+
         //  Processes commands sent to this thread (if any). If 'block' is
         //  set to true, returns only after at least one command was processed.
-        //  If throttle argument is true, commands are processed at most once
-        //  in a predefined time period.
-        void process_commands (bool block_, bool throttle_);
+        //  If throttle argument is non-zero, commands are processed at most
+        //  once per 'throttle' CPU ticks.
+        void process_commands (bool block_, uint64_t throttle_);
+
+        //  Processes commands sent to this thread once the signaler's file
+        //  descriptor was reported readable by poll or similar. Unlike the
+        //  non-blocking process_commands, the signal is always consumed,
+        //  otherwise the descriptor would stay readable.
+        void process_signaled_commands ();
 
         //  Create a socket of a specified type.
         class socket_base_t *create_socket (int type_);
@@ -62,6 +71,9 @@ namespace zmq
         //  App thread's signaler object.
         struct i_signaler *signaler;
 
+        //  Mailbox to receive commands from other threads.
+        class mailbox_t *mailbox;
+
         //  Timestamp of when commands were processed the last time.
         uint64_t last_processing_time;
 
@@ -253,6 +253,13 @@ namespace zmq
 #endif
         }
 
+        //  Returns the address of the underlying integer so that a thread
+        //  can wait for it to change (futex).
+        inline volatile bitmap_t *get_address ()
+        {
+            return &value;
+        }
+
     private:
 
         volatile bitmap_t value;
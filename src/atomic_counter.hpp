@@ -129,7 +129,7 @@ namespace zmq
             __asm__ volatile ("lock; xaddl %0,%1"
                 : "=r" (oldval), "=m" (*val)
                 : "0" (oldval), "m" (*val)
-                : "cc");
+                : "cc", "memory");
             return oldval != decrement;
 #elif defined ZMQ_ATOMIC_COUNTER_SPARC
             volatile integer_t *val = &value;
@@ -86,7 +86,8 @@ namespace zmq
             __asm__ volatile (
                 "lock; xchg %0, %2"
                 : "=r" (old), "=m" (ptr)
-                : "m" (ptr), "0" (val_));
+                : "m" (ptr), "0" (val_)
+                : "memory");
             return old;
 #elif defined ZMQ_ATOMIC_PTR_SPARC
             T* newptr = val_;
@@ -133,7 +134,7 @@ namespace zmq
                 "lock; cmpxchg %2, %3"
                 : "=a" (old), "=m" (ptr)
                 : "r" (val_), "m" (ptr), "0" (cmp_)
-                : "cc");
+                : "cc", "memory");
             return old;
 #elif defined ZMQ_ATOMIC_PTR_SPARC
             volatile T** ptrin = &ptr;
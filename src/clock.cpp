@@ -0,0 +1,53 @@
+/*
+    Copyright (c) 2007-2010 iMatix Corporation
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the Lesser GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    Lesser GNU General Public License for more details.
+
+    You should have received a copy of the Lesser GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "platform.hpp"
+
+#ifdef ZMQ_HAVE_WINDOWS
+#include "windows.hpp"
+#else
+#include <time.h>
+#include <sys/time.h>
+#endif
+
+#include "clock.hpp"
+#include "err.hpp"
+
+uint64_t zmq::now_us ()
+{
+#if defined ZMQ_HAVE_WINDOWS
+    //  Convert the high resolution counter to microseconds since the system
+    //  was started.
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency (&frequency);
+    LARGE_INTEGER tick;
+    QueryPerformanceCounter (&tick);
+    return (uint64_t) (tick.QuadPart / (frequency.QuadPart / 1000000.0));
+#elif defined CLOCK_MONOTONIC
+    timespec ts;
+    int rc = clock_gettime (CLOCK_MONOTONIC, &ts);
+    errno_assert (rc == 0);
+    return ((uint64_t) ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+#else
+    timeval tv;
+    int rc = gettimeofday (&tv, NULL);
+    errno_assert (rc == 0);
+    return ((uint64_t) tv.tv_sec) * 1000000 + tv.tv_usec;
+#endif
+}
@@ -86,10 +86,11 @@ namespace zmq
             } revive;
 
             //  Sent by pipe reader to inform pipe writer
-            //  about how many messages it has read so far.
+            //  about how many messages and bytes it has read so far.
             //  Used to implement the flow control.
             struct {
                 uint64_t msgs_read;
+                uint64_t bytes_read;
             } reader_info;
 
             //  Sent by pipe reader to pipe writer to ask it to terminate
@@ -32,43 +32,83 @@ namespace zmq
         //  memory allocation by approximately 99.6%
         message_pipe_granularity = 256,
 
-        //  Number of new commands in command pipe needed to trigger new memory
-        //  allocation. The number should  be kept low to decrease the memory
-        //  footprint of dispatcher.
-        command_pipe_granularity = 4,
-
         //  Determines how often does socket poll for new commands when it
         //  still has unprocessed messages to handle. Thus, if it is set to 100,
         //  socket will process 100 inbound messages before doing the poll.
         //  If there are no unprocessed messages available, poll is done
         //  immediately. Decreasing the value trades overall latency for more
-        //  real-time behaviour (less latency peaks).
+        //  real-time behaviour (less latency peaks). This is the default for
+        //  the ZMQ_INBOUND_POLL_RATE option.
         inbound_poll_rate = 100,
 
         //  Maximal batching size for engines with receiving functionality.
         //  So, if there are 10 messages that fit into the batch size, all of
         //  them may be read by a single 'recv' system call, thus avoiding
-        //  unnecessary network stack traversals.
+        //  unnecessary network stack traversals. This is the default for
+        //  the ZMQ_IN_BATCH_SIZE option.
         in_batch_size = 8192,
 
         //  Maximal batching size for engines with sending functionality.
         //  So, if there are 10 messages that fit into the batch size, all of
         //  them may be written by a single 'send' system call, thus avoiding
-        //  unnecessary network stack traversals.
-        out_batch_size = 8192,        
+        //  unnecessary network stack traversals. This is the default for
+        //  the ZMQ_OUT_BATCH_SIZE option.
+        out_batch_size = 8192,
+
+        //  Messages up to this size (and larger than VSM) received by an
+        //  engine are not copied out of the receive buffer. Instead they
+        //  refer directly to the portion of the buffer holding them. Note
+        //  that a single such message keeps the whole batch buffer alive,
+        //  i.e. about 18kB with the default in_batch_size. If small messages
+        //  are held by the application for long, setting the value to 0
+        //  disables the feature.
+        in_slice_max_size = 512,
+
+        //  Message bodies up to this size are copied into the outgoing batch
+        //  buffer by engines with sending functionality. Larger bodies are
+        //  passed to the network stack directly from the message, using
+        //  gather write. Value should not be less than ZMQ_MAX_VSM_SIZE.
+        out_copy_max_size = 1024,
+
+        //  Maximal number of separate data chunks to be passed to a single
+        //  gather write.
+        out_batch_chunks = 16,
 
         //  Maximum number of events the I/O thread can process in one go.
         max_io_events = 256,
 
-        //  Maximal wait time for a timer (milliseconds).
-        max_timer_period = 100,
+        //  Size of the portion of the swap file mapped into memory at a time.
+        //  It has to be a multiple of the page size (allocation granularity
+        //  on Windows).
+        swap_window_size = 1024 * 1024,
+
+        //  Maximal size of a message buffer (including its header) to be
+        //  allocated from per-thread pools. Larger buffers are allocated
+        //  directly from the heap.
+        msg_pool_max_block_size = 8192,
+
+        //  Maximal amount of memory (in bytes) held in free buffers of each
+        //  size class by a single thread, unless the buffers were passed
+        //  back by other threads.
+        msg_pool_cache_size = 1024 * 1024,
+
+        //  Number of points representing each outbound pipe on
+        //  the consistent-hash ring. More points spread the keys more evenly
+        //  among the pipes at the cost of memory and slower attach/detach.
+        consistent_hash_points = 64,
+
+        //  Time to wait before attempting to reconnect a disconnected TCP
+        //  connection (milliseconds).
+        reconnect_ivl = 100,
 
         //  Maximal delay to process command in API thread (in CPU ticks).
         //  3,000,000 ticks equals to 1 - 2 milliseconds on current CPUs.
+        //  This is the default for the ZMQ_COMMAND_DELAY option.
         max_command_delay = 3000000,
 
         //  Maximal number of non-accepted connections that can be held by
-        //  TCP listener object.
+        //  TCP listener object. This is the default for the ZMQ_BACKLOG
+        //  option.
         tcp_connection_backlog = 10,
 
         //  Maximum transport data unit size for PGM (TPDU).
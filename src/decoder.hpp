@@ -24,7 +24,12 @@
 #include <string.h>
 #include <stdlib.h>
 #include <algorithm>
+#include <new>
 
+#include "../include/zmq.h"
+
+#include "atomic_counter.hpp"
+#include "msg_content.hpp"
 #include "err.hpp"
 
 namespace zmq
@@ -40,6 +45,13 @@ namespace zmq
     //
     //  Decoder implements the state machine that parses the incoming buffer.
     //  Derived class should implement individual state machine actions.
+    //
+    //  The buffer provided by get_buffer is reference-counted. Derived class
+    //  may use slice function to create messages pointing directly into the
+    //  buffer rather than copying the data out of it. Headers of such
+    //  messages are carved from the same block of memory as the buffer, so
+    //  slicing requires no allocation at all. On the other hand, a single
+    //  sliced message keeps the whole block alive till it's closed.
 
     template <typename T> class decoder_t
     {
@@ -49,15 +61,17 @@ namespace zmq
             read_pos (NULL),
             to_read (0),
             next (NULL),
-            bufsize (bufsize_)
+            in_pos (NULL),
+            in_size (0),
+            bufsize (bufsize_),
+            max_slices (bufsize_ / (ZMQ_MAX_VSM_SIZE + 3))
         {
-            buf = (unsigned char*) malloc (bufsize_);
-            zmq_assert (buf);
+            buffer = alloc_buffer ();
         }
 
         inline ~decoder_t ()
         {
-            free (buf);
+            release_buffer (NULL, buffer);
         }
 
         //  Returns a buffer to be filled with binary data.
@@ -77,6 +91,15 @@ namespace zmq
                 return;
             }
 
+            //  If there are messages still referring to the buffer, it cannot
+            //  be overwritten. Allocate a new one.
+            if (buffer->refcnt.get () != 1) {
+                release_buffer (NULL, buffer);
+                buffer = alloc_buffer ();
+            }
+            else
+                buffer->slices = 0;
+
             *data_ = buf;
             *size_ = bufsize;
         }
@@ -90,7 +113,7 @@ namespace zmq
             //  In case of zero-copy simply adjust the pointers, no copying
             //  is required. Also, run the state machine in case all the data
             //  were processed.
-            if (data_ == read_pos) {
+            if (data_ == read_pos && to_read) {
                 read_pos += size_;
                 to_read -= size_;
 
@@ -104,18 +127,26 @@ namespace zmq
             while (true) {
 
                 //  Try to get more space in the message to fill in.
-                //  If none is available, return.
+                //  If none is available, return. Remember the unprocessed
+                //  data so that state machine actions can slice them.
+                in_pos = data_ + pos;
+                in_size = size_ - pos;
                 while (!to_read)
-                    if (!(static_cast <T*> (this)->*next) ())
+                    if (!(static_cast <T*> (this)->*next) ()) {
+                        in_size = 0;
                         return pos;
+                    }
+                in_size = 0;
 
                 //  If there are no more data in the buffer, return.
                 if (pos == size_)
                     return pos;
 
-                //  Copy the data from buffer to the message.
+                //  Copy the data from buffer to the message. If the message
+                //  was sliced out of the buffer, the data are already in place.
                 size_t to_copy = std::min (to_read, size_ - pos);
-                memcpy (read_pos, data_ + pos, to_copy);
+                if (read_pos != data_ + pos)
+                    memcpy (read_pos, data_ + pos, to_copy);
                 read_pos += to_copy;
                 pos += to_copy;
                 to_read -= to_copy;
@@ -138,13 +169,83 @@ namespace zmq
             next = next_;
         }
 
+        //  If the next size_ bytes of input are already available in the
+        //  receive buffer, initialises msg_ to point directly to them and
+        //  returns true. The data will be skipped by the decoder when
+        //  the caller schedules reading them into the message.
+        inline bool slice (::zmq_msg_t *msg_, size_t size_)
+        {
+            if (in_size < size_ || in_pos < buf || in_pos >= buf + bufsize ||
+                  buffer->slices == max_slices)
+                return false;
+
+            msg_content_t *content =
+                ((msg_content_t*) (buffer + 1)) + buffer->slices;
+            buffer->slices++;
+            buffer->refcnt.add (1);
+
+            content->data = in_pos;
+            content->size = size_;
+            content->ffn = release_buffer;
+            content->hint = buffer;
+            new (&content->refcnt) atomic_counter_t ();
+            content->embedded = true;
+
+            msg_->content = content;
+            msg_->flags = 0;
+            return true;
+        }
+
     private:
 
+        //  Header of the receive buffer. It is followed by max_slices
+        //  message headers and then by the data.
+        struct buffer_t
+        {
+            atomic_counter_t refcnt;
+
+            //  Number of message headers used so far.
+            size_t slices;
+        };
+
+        inline buffer_t *alloc_buffer ()
+        {
+            buffer_t *b = (buffer_t*) malloc (sizeof (buffer_t) +
+                max_slices * sizeof (msg_content_t) + bufsize);
+            zmq_assert (b);
+            new (&b->refcnt) atomic_counter_t (1);
+            b->slices = 0;
+            buf = (unsigned char*) (((msg_content_t*) (b + 1)) + max_slices);
+            return b;
+        }
+
+        //  Drops a reference to the buffer. Used as a deallocation
+        //  function for the messages sliced out of the buffer.
+        static void release_buffer (void *data_, void *hint_)
+        {
+            buffer_t *b = (buffer_t*) hint_;
+            if (!b->refcnt.sub (1)) {
+                b->refcnt.~atomic_counter_t ();
+                free (b);
+            }
+        }
+
         unsigned char *read_pos;
         size_t to_read;
         step_t next;
 
+        //  Unprocessed part of the data being processed by process_buffer.
+        unsigned char *in_pos;
+        size_t in_size;
+
         size_t bufsize;
+
+        //  Maximal number of messages sliced out of a single buffer. There's
+        //  a header for each message at least VSM-sized plus 2 bytes of
+        //  framing that fits into the buffer.
+        size_t max_slices;
+
+        buffer_t *buffer;
         unsigned char *buf;
 
         decoder_t (const decoder_t&);
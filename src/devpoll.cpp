@@ -128,16 +128,15 @@ void zmq::devpoll_t::reset_pollout (handle_t handle_)
     devpoll_ctl (handle_, fd_table [handle_].events);
 }
 
-void zmq::devpoll_t::add_timer (i_poll_events *events_)
+zmq::timer_wheel_t::handle_t zmq::devpoll_t::add_timer (int timeout_,
+    i_poll_events *events_, int id_)
 {
-     timers.push_back (events_);
+    return timers.add (timeout_, events_, id_);
 }
 
-void zmq::devpoll_t::cancel_timer (i_poll_events *events_)
+void zmq::devpoll_t::cancel_timer (timer_wheel_t::handle_t handle_)
 {
-    timers_t::iterator it = std::find (timers.begin (), timers.end (), events_);
-    if (it != timers.end ())
-        timers.erase (it);
+    timers.cancel (handle_);
 }
 
 int zmq::devpoll_t::get_load ()
@@ -163,6 +162,9 @@ void zmq::devpoll_t::loop ()
 
     while (!stopping) {
 
+        //  Execute any due timers.
+        int timeout = timers.execute ();
+
         struct pollfd ev_buf [max_io_events];
         struct dvpoll poll_req;
 
@@ -172,7 +174,7 @@ void zmq::devpoll_t::loop ()
 
         poll_req.dp_fds = &ev_buf [0];
         poll_req.dp_nfds = nfds;
-        poll_req.dp_timeout = timers.empty () ? -1 : max_timer_period;
+        poll_req.dp_timeout = timeout;
 
         //  Wait for events.
         int n = ioctl (devpoll_fd, DP_POLL, &poll_req);
@@ -180,21 +182,6 @@ void zmq::devpoll_t::loop ()
             continue;
         errno_assert (n != -1);
 
-        //  Handle timer.
-        if (!n) {
-
-            //  Use local list of timers as timer handlers may fill new timers
-            //  into the original array.
-            timers_t t;
-            std::swap (timers, t);
-
-            //  Trigger all the timers.
-            for (timers_t::iterator it = t.begin (); it != t.end (); it ++)
-                (*it)->timer_event ();
-
-            continue;
-        }
-
         for (int i = 0; i < n; i ++) {
 
             fd_entry_t *fd_ptr = &fd_table [ev_buf [i].fd];
@@ -56,7 +56,7 @@ zmq::dispatcher_t::dispatcher_t (int app_threads_, int io_threads_,
         info.app_thread = new (std::nothrow) app_thread_t (this, i, flags_);
         zmq_assert (info.app_thread);
         app_threads.push_back (info);
-        signalers.push_back (info.app_thread->get_signaler ());
+        mailboxes.push_back (info.app_thread->get_mailbox ());
     }
 
     //  Create I/O thread objects.
@@ -65,20 +65,9 @@ zmq::dispatcher_t::dispatcher_t (int app_threads_, int io_threads_,
             i + app_threads_, flags_);
         zmq_assert (io_thread);
         io_threads.push_back (io_thread);
-        signalers.push_back (io_thread->get_signaler ());
+        mailboxes.push_back (io_thread->get_mailbox ());
     }
 
-    //  Create the administrative thread. Nothing special is needed. NULL
-    //  is used instead of signaler given that as for now, administrative
-    //  thread doesn't receive any commands. The only thing it is used for
-    //  is sending 'stop' command to I/O threads on shutdown.
-    signalers.push_back (NULL);
-
-    //  Create command pipe matrix.
-    command_pipes = new  (std::nothrow) command_pipe_t [signalers.size () *
-         signalers.size ()];
-    zmq_assert (command_pipes);
-
     //  Launch I/O threads.
     for (int i = 0; i != io_threads_; i++)
         io_threads [i]->start ();
@@ -105,7 +94,8 @@ zmq::dispatcher_t::~dispatcher_t ()
     for (io_threads_t::size_type i = 0; i != io_threads.size (); i++)
         io_threads [i]->stop ();
 
-    //  Wait till I/O threads actually terminate.
+    //  Wait till I/O threads actually terminate. Commands still waiting in
+    //  the mailboxes are deallocated along with the threads.
     for (io_threads_t::size_type i = 0; i != io_threads.size (); i++)
         delete io_threads [i];
 
@@ -117,12 +107,6 @@ zmq::dispatcher_t::~dispatcher_t ()
     while (!pipes.empty ())
         delete *pipes.begin ();
 
-    //  TODO: Deallocate any commands still in the pipes. Keep in mind that
-    //  simple reading from a pipe and deallocating commands won't do as
-    //  command pipe has template parameter D set to true, meaning that
-    //  read may return false even if there are still commands in the pipe.
-    delete [] command_pipes;
-
 #ifdef ZMQ_HAVE_WINDOWS
     //  On Windows, uninitialise socket layer.
     int rc = WSACleanup ();
@@ -132,7 +116,36 @@ zmq::dispatcher_t::~dispatcher_t ()
 
 int zmq::dispatcher_t::thread_slot_count ()
 {
-    return signalers.size ();
+    return mailboxes.size ();
+}
+
+int zmq::dispatcher_t::setctxopt (int option_, const void *optval_,
+    size_t optvallen_)
+{
+    switch (option_) {
+    case ZMQ_IN_BATCH_SIZE:
+    case ZMQ_OUT_BATCH_SIZE:
+    case ZMQ_INBOUND_POLL_RATE:
+    case ZMQ_COMMAND_DELAY:
+    case ZMQ_BACKLOG:
+        break;
+    default:
+        errno = EINVAL;
+        return -1;
+    }
+
+    socket_defaults_sync.lock ();
+    int rc = socket_defaults.setsockopt (option_, optval_, optvallen_);
+    socket_defaults_sync.unlock ();
+    return rc;
+}
+
+zmq::options_t zmq::dispatcher_t::get_socket_defaults ()
+{
+    socket_defaults_sync.lock ();
+    options_t options = socket_defaults;
+    socket_defaults_sync.unlock ();
+    return options;
 }
 
 zmq::socket_base_t *zmq::dispatcher_t::create_socket (int type_)
@@ -207,21 +220,9 @@ void zmq::dispatcher_t::no_sockets (app_thread_t *thread_)
     app_threads_sync.unlock ();
 }
 
-void zmq::dispatcher_t::write (int source_, int destination_,
-    const command_t &command_)
-{
-    command_pipe_t &pipe =
-        command_pipes [source_ * signalers.size () + destination_];
-    pipe.write (command_);
-    if (!pipe.flush ())
-        signalers [destination_]->signal (source_);
-}
-
-bool zmq::dispatcher_t::read (int source_,  int destination_,
-    command_t *command_)
+void zmq::dispatcher_t::write (int destination_, const command_t &command_)
 {
-    return command_pipes [source_ * signalers.size () +
-        destination_].read (command_);
+    mailboxes [destination_]->send (command_);
 }
 
 zmq::io_thread_t *zmq::dispatcher_t::choose_io_thread (uint64_t affinity_)
@@ -231,7 +232,9 @@ zmq::io_thread_t *zmq::dispatcher_t::choose_io_thread (uint64_t affinity_)
     int min_load = -1;
     io_threads_t::size_type result = 0;
     for (io_threads_t::size_type i = 0; i != io_threads.size (); i++) {
-        if (!affinity_ || (affinity_ & (uint64_t (1) << i))) {
+        //  Affinity bitmap can refer only to the first 64 I/O threads.
+        //  The remaining ones are eligible only if no affinity is set.
+        if (!affinity_ || (i < 64 && (affinity_ & (uint64_t (1) << i)))) {
             int load = io_threads [i]->get_load ();
             if (min_load == -1 || load < min_load) {
                 min_load = load;
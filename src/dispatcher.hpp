@@ -25,10 +25,9 @@
 #include <map>
 #include <string>
 
-#include "i_signaler.hpp"
-#include "ypipe.hpp"
+#include "mailbox.hpp"
 #include "command.hpp"
-#include "config.hpp"
+#include "options.hpp"
 #include "mutex.hpp"
 #include "stdint.hpp"
 #include "thread.hpp"
@@ -37,20 +36,20 @@ namespace zmq
 {
 
     //  Dispatcher implements bidirectional thread-safe passing of commands
-    //  between N threads. It consists of a ypipes to pass commands and
-    //  signalers to wake up the receiver thread when new commands are
-    //  available. Note that dispatcher is inefficient for passing messages
-    //  within a thread (sender thread = receiver thread). The optimisation is
-    //  not part of the class and should be implemented by individual threads
-    //  (presumably by calling the command handling function directly).
+    //  between N threads. Each thread owns a mailbox that any other thread
+    //  can post commands to. Mailbox wakes up the receiver thread when new
+    //  commands become available. Note that dispatcher is inefficient for
+    //  passing messages within a thread (sender thread = receiver thread).
+    //  The optimisation is not part of the class and should be implemented
+    //  by individual threads (presumably by calling the command handling
+    //  function directly).
     
     class dispatcher_t
     {
     public:
 
-        //  Create the dispatcher object. Matrix of pipes to communicate between
-        //  each socket and each I/O thread is created along with appropriate
-        //  signalers.
+        //  Create the dispatcher object. Application threads and I/O threads
+        //  are created along with their mailboxes.
         dispatcher_t (int app_threads_, int io_threads_, int flags_);
 
         //  This function is called when user invokes zmq_term. If there are
@@ -59,6 +58,14 @@ namespace zmq
         //  after the last one is closed.
         int term ();
 
+        //  Set an option for all the sockets created afterwards. Only the
+        //  options tuning the engines and the command processing can be set
+        //  on the context.
+        int setctxopt (int option_, const void *optval_, size_t optvallen_);
+
+        //  Returns the options newly created sockets start with.
+        options_t get_socket_defaults ();
+
         //  Create a socket.
         class socket_base_t *create_socket (int type_);
 
@@ -69,17 +76,12 @@ namespace zmq
         //  should disassociate the object from the current OS thread.
         void no_sockets (class app_thread_t *thread_);
 
-        //  Returns number of thread slots in the dispatcher. To be used by
-        //  individual threads to find out how many distinct signals can be
-        //  received.
+        //  Returns number of thread slots in the dispatcher.
         int thread_slot_count ();
 
-        //  Send command from the source to the destination.
-        void write (int source_, int destination_, const command_t &command_);
-
-        //  Receive command from the source. Returns false if there is no
-        //  command available.
-        bool read (int source_,  int destination_, command_t *command_);
+        //  Send command to the destination thread. The command can be sent
+        //  from any thread, including threads not managed by 0MQ.
+        void write (int destination_, const command_t &command_);
 
         //  Returns the I/O thread that is the least busy at the moment.
         //  Taskset specifies which I/O threads are eligible (0 = all).
@@ -124,15 +126,9 @@ namespace zmq
         typedef std::vector <class io_thread_t*> io_threads_t;
         io_threads_t io_threads;
 
-        //  Signalers for both application and I/O threads.
-        std::vector <i_signaler*> signalers;
-
-        //  Pipe to hold the commands.
-        typedef ypipe_t <command_t, true,
-            command_pipe_granularity> command_pipe_t;
-
-        //  NxN matrix of command pipes.
-        command_pipe_t *command_pipes;
+        //  Mailboxes for both application and I/O threads. Mailboxes are
+        //  owned by the individual threads.
+        std::vector <mailbox_t*> mailboxes;
 
         //  As pipes may reside in orphaned state in particular moments
         //  of the pipe shutdown process, i.e. neither pipe reader nor
@@ -164,6 +160,12 @@ namespace zmq
         //  Synchronisation of access to the list of inproc endpoints.
         mutex_t endpoints_sync;
 
+        //  Options newly created sockets start with.
+        options_t socket_defaults;
+
+        //  Synchronisation of access to the default socket options.
+        mutex_t socket_defaults_sync;
+
         dispatcher_t (const dispatcher_t&);
         void operator = (const dispatcher_t&);
     };
@@ -38,7 +38,7 @@ void zmq::downstream_t::xattach_pipes (class reader_t *inpipe_,
     class writer_t *outpipe_, const blob_t &peer_identity_)
 {
     zmq_assert (!inpipe_ && outpipe_);
-    lb.attach (outpipe_);
+    lb.attach (outpipe_, peer_identity_);
 }
 
 void zmq::downstream_t::xdetach_inpipe (class reader_t *pipe_)
@@ -73,7 +73,11 @@ void zmq::downstream_t::xrevive (class writer_t *pipe_)
 int zmq::downstream_t::xsetsockopt (int option_, const void *optval_,
     size_t optvallen_)
 {
-    //  No special option for this socket type.
+    if (option_ == ZMQ_BALANCE)
+        return lb.set_balance (optval_, optvallen_);
+    if (option_ == ZMQ_BALANCE_KEY_SIZE)
+        return lb.set_key_size (optval_, optvallen_);
+
     errno = EINVAL;
     return -1;
 }
@@ -89,6 +93,11 @@ int zmq::downstream_t::xrecv (zmq_msg_t *msg_, int flags_)
     return -1;
 }
 
+void zmq::downstream_t::xflush ()
+{
+    lb.flush ();
+}
+
 bool zmq::downstream_t::xhas_in ()
 {
     return false;
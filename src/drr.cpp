@@ -0,0 +1,103 @@
+/*
+    Copyright (c) 2007-2010 iMatix Corporation
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the Lesser GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    Lesser GNU General Public License for more details.
+
+    You should have received a copy of the Lesser GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <algorithm>
+
+#include "../include/zmq.h"
+
+#include "drr.hpp"
+#include "err.hpp"
+
+zmq::drr_t::drr_t () :
+    quantum (0)
+{
+}
+
+zmq::drr_t::~drr_t ()
+{
+}
+
+int zmq::drr_t::set_quantum (const void *optval_, size_t optvallen_)
+{
+    if (optvallen_ != sizeof (uint64_t)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    //  Limit the quantum so that the credits can't overflow.
+    uint64_t quantum_ = *((uint64_t*) optval_);
+    if (quantum_ > 0x7fffffff) {
+        errno = EINVAL;
+        return -1;
+    }
+    quantum = quantum_;
+    return 0;
+}
+
+void zmq::drr_t::push_back ()
+{
+    deficits.push_back (0);
+}
+
+void zmq::drr_t::swap (size_type index1_, size_type index2_)
+{
+    std::swap (deficits [index1_], deficits [index2_]);
+}
+
+void zmq::drr_t::erase (size_type index_)
+{
+    deficits [index_] = deficits.back ();
+    deficits.pop_back ();
+}
+
+void zmq::drr_t::deactivate (size_type index_)
+{
+    if (deficits [index_] > 0)
+        deficits [index_] = 0;
+}
+
+void zmq::drr_t::charge (size_type index_, size_t size_)
+{
+    if (quantum)
+        deficits [index_] -= (int64_t) size_;
+}
+
+void zmq::drr_t::pass_turn (size_type &current_, size_type active_,
+    size_type &skipped_)
+{
+    //  If no pipe has any credit, credit all the pipes at once so that
+    //  the first one gets positive in the next round.
+    if (++skipped_ >= active_) {
+        int64_t max = deficits [0];
+        for (size_type i = 1; i != active_; i++)
+            max = std::max (max, deficits [i]);
+        if (max < 0) {
+            int64_t credit = (-max / (int64_t) quantum) * (int64_t) quantum;
+            for (size_type i = 0; i != active_; i++)
+                deficits [i] += credit;
+        }
+        skipped_ = 0;
+    }
+
+    current_++;
+    if (current_ >= active_)
+        current_ = 0;
+    deficits [current_] += (int64_t) quantum;
+}
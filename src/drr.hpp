@@ -0,0 +1,104 @@
+/*
+    Copyright (c) 2007-2010 iMatix Corporation
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the Lesser GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    Lesser GNU General Public License for more details.
+
+    You should have received a copy of the Lesser GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef __ZMQ_DRR_HPP_INCLUDED__
+#define __ZMQ_DRR_HPP_INCLUDED__
+
+#include <stddef.h>
+#include <vector>
+
+#include "stdint.hpp"
+
+namespace zmq
+{
+
+    //  Credit accounting for deficit round robin over a set of inbound
+    //  pipes. The credits are stored at the same indices as the pipes
+    //  in the owner's array, thus the owner has to mirror every change
+    //  of the array here. Active pipes are expected to be located at
+    //  the beginning of the array, the same way as in fq_t.
+
+    class drr_t
+    {
+    public:
+
+        typedef std::vector <int64_t>::size_type size_type;
+
+        drr_t ();
+        ~drr_t ();
+
+        //  Sets the number of bytes each pipe is credited with per round
+        //  (ZMQ_QUANTUM socket option). Zero means that the pipes take
+        //  turns message by message and no credits are accounted for.
+        int set_quantum (const void *optval_, size_t optvallen_);
+
+        //  Returns true if deficit round robin is used.
+        inline bool enabled ()
+        {
+            return quantum != 0;
+        }
+
+        //  Mirror the changes of the pipe array. Pipes are added with no
+        //  credit. Erasing moves the last pipe to the place of the erased
+        //  one.
+        void push_back ();
+        void swap (size_type index1_, size_type index2_);
+        void erase (size_type index_);
+
+        //  Called when the pipe at index_ has no more messages to read.
+        //  The pipe doesn't keep the unused credit, however, it still has
+        //  to pay off its debt.
+        void deactivate (size_type index_);
+
+        //  Returns true if the pipe at index_ may be read from.
+        inline bool has_credit (size_type index_)
+        {
+            return deficits [index_] > 0;
+        }
+
+        //  Charges the pipe at index_ for a message of size_ bytes. The
+        //  credit goes negative when the message is larger than the credit
+        //  left; the debt is paid off in following rounds.
+        void charge (size_type index_, size_t size_);
+
+        //  Passes the turn from current_ to the next of the first active_
+        //  pipes and credits it with the quantum. 'skipped_' counts pipes
+        //  found to have no credit in a row. Once none of the pipes has
+        //  any, the rounds in which none of them would get positive are
+        //  fast-forwarded.
+        void pass_turn (size_type &current_, size_type active_,
+            size_type &skipped_);
+
+    private:
+
+        //  Number of bytes each pipe is credited with when its turn comes.
+        uint64_t quantum;
+
+        //  Credit of the pipes in bytes.
+        typedef std::vector <int64_t> deficits_t;
+        deficits_t deficits;
+
+        drr_t (const drr_t&);
+        void operator = (const drr_t&);
+    };
+
+}
+
+#endif
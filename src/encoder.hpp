@@ -30,9 +30,23 @@
 namespace zmq
 {
 
+    //  Contiguous piece of data to be written by a gather write.
+
+    struct chunk_t
+    {
+        unsigned char *data;
+        size_t size;
+    };
+
     //  Helper base class for encoders. It implements the state machine that
     //  fills the outgoing buffer. Derived classes should implement individual
     //  state machine actions.
+    //
+    //  To use get_chunks, derived class has to implement 'retain' and
+    //  'release' functions. 'retain' is called when the data scheduled by
+    //  the last next_step call are going to be written directly rather than
+    //  copied to the buffer, so they have to be kept alive. 'release' is
+    //  called when all the retained data were written.
 
     template <typename T> class encoder_t
     {
@@ -119,6 +133,71 @@ namespace zmq
             }
         }
 
+        //  The function returns a batch of data as an array of chunks to be
+        //  written using a single gather write. Data smaller than threshold_
+        //  are copied into the internal buffer, larger data are referred to
+        //  directly. At most count_ chunks are filled in; the actual number
+        //  of chunks is returned in count_. The chunks returned from the
+        //  previous call are invalidated.
+        inline void get_chunks (chunk_t *chunks_, int *count_,
+            size_t threshold_)
+        {
+            static_cast <T*> (this)->release ();
+
+            int max = *count_;
+            int count = 0;
+            size_t pos = 0;
+            size_t chunk_start = 0;
+
+            while (true) {
+
+                //  If there are no more data to return, run the state machine.
+                //  If there are still no data, return what we already have.
+                if (!to_write) {
+                    if (!(static_cast <T*> (this)->*next) ())
+                        break;
+                    beginning = false;
+                    continue;
+                }
+
+                //  Large data are not copied. Keep one chunk free for the
+                //  data copied into the buffer afterwards.
+                if (to_write > threshold_) {
+                    if (count + 3 > max)
+                        break;
+                    if (pos > chunk_start) {
+                        chunks_ [count].data = buf + chunk_start;
+                        chunks_ [count].size = pos - chunk_start;
+                        count++;
+                        chunk_start = pos;
+                    }
+                    chunks_ [count].data = write_pos;
+                    chunks_ [count].size = to_write;
+                    count++;
+                    static_cast <T*> (this)->retain ();
+                    write_pos += to_write;
+                    to_write = 0;
+                    continue;
+                }
+
+                //  Copy data to the buffer. If the buffer is full, return.
+                if (pos == bufsize)
+                    break;
+                size_t to_copy = std::min (to_write, bufsize - pos);
+                memcpy (buf + pos, write_pos, to_copy);
+                pos += to_copy;
+                write_pos += to_copy;
+                to_write -= to_copy;
+            }
+
+            if (pos > chunk_start) {
+                chunks_ [count].data = buf + chunk_start;
+                chunks_ [count].size = pos - chunk_start;
+                count++;
+            }
+            *count_ = count;
+        }
+
     protected:
 
         //  Prototype of state machine action.
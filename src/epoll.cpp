@@ -120,17 +120,15 @@ void zmq::epoll_t::reset_pollout (handle_t handle_)
     errno_assert (rc != -1);
 }
 
-void zmq::epoll_t::add_timer (i_poll_events *events_)
+zmq::timer_wheel_t::handle_t zmq::epoll_t::add_timer (int timeout_,
+    i_poll_events *events_, int id_)
 {
-     timers.push_back (events_);
+    return timers.add (timeout_, events_, id_);
 }
 
-void zmq::epoll_t::cancel_timer (i_poll_events *events_)
+void zmq::epoll_t::cancel_timer (timer_wheel_t::handle_t handle_)
 {
-    timers_t::iterator it = std::find (timers.begin (), timers.end (), events_);
-    if (it == timers.end ())
-        return;
-    timers.erase (it);
+    timers.cancel (handle_);
 }
 
 int zmq::epoll_t::get_load ()
@@ -154,32 +152,19 @@ void zmq::epoll_t::loop ()
 
     while (!stopping) {
 
+        //  Execute any due timers.
+        int timeout = timers.execute ();
+
         //  Wait for events.
         int n;
         while (true) {
-            n = epoll_wait (epoll_fd, &ev_buf [0], max_io_events,
-                timers.empty () ? -1 : max_timer_period);
+            n = epoll_wait (epoll_fd, &ev_buf [0], max_io_events, timeout);
             if (!(n == -1 && errno == EINTR)) {
                 errno_assert (n != -1);
                 break;
             }
         }
 
-        //  Handle timer.
-        if (!n) {
-
-            //  Use local list of timers as timer handlers may fill new timers
-            //  into the original array.
-            timers_t t;
-            std::swap (timers, t);
-
-            //  Trigger all the timers.
-            for (timers_t::iterator it = t.begin (); it != t.end (); it ++)
-                (*it)->timer_event ();
-
-            continue;
-        }
-
         for (int i = 0; i < n; i ++) {
             poll_entry_t *pe = ((poll_entry_t*) ev_buf [i].data.ptr);
 
@@ -35,6 +35,7 @@
 #if defined ZMQ_HAVE_EVENTFD
 
 #include <sys/eventfd.h>
+#include <poll.h>
 
 zmq::fd_signaler_t::fd_signaler_t ()
 {
@@ -56,51 +57,39 @@ zmq::fd_signaler_t::~fd_signaler_t ()
     errno_assert (rc != -1);
 }
 
-void zmq::fd_signaler_t::signal (int signal_)
+void zmq::fd_signaler_t::signal ()
 {
-    zmq_assert (signal_ >= 0 && signal_ < 64);
     uint64_t inc = 1;
-    inc <<= signal_;
     ssize_t sz = write (fd, &inc, sizeof (uint64_t));
     errno_assert (sz == sizeof (uint64_t));
 }
 
-uint64_t zmq::fd_signaler_t::poll ()
+void zmq::fd_signaler_t::poll ()
 {
-    //  Set to blocking mode.
-    int flags = fcntl (fd, F_GETFL, 0);
-    if (flags == -1)
-        flags = 0;
-    int rc = fcntl (fd, F_SETFL, flags & ~O_NONBLOCK);
-    errno_assert (rc != -1);
-
-    uint64_t signals;
-    ssize_t sz;
-    while (true) {
-        sz = read (fd, &signals, sizeof (uint64_t));
-        if (sz == -1) {
-            if (errno == EAGAIN || errno == EINTR)
-                continue;
-            errno_assert (false);
-        }
-        break;
-    }
-
-    //  Set to non-blocking mode.
-    rc = fcntl (fd, F_SETFL, flags | O_NONBLOCK);
+    //  Wait for the eventfd to become readable and then read the signals.
+    //  The eventfd stays in non-blocking mode all the time so that there's
+    //  no need to switch it to blocking mode and back on each wait.
+    pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    int rc;
+    do {
+        rc = ::poll (&pfd, 1, -1);
+    } while (rc == -1 && errno == EINTR);
     errno_assert (rc != -1);
 
-    return signals;
+    bool signaled = check ();
+    zmq_assert (signaled);
 }
 
-uint64_t zmq::fd_signaler_t::check ()
+bool zmq::fd_signaler_t::check ()
 {
     uint64_t signals;
     ssize_t sz = read (fd, &signals, sizeof (uint64_t));
     if (sz == -1 && (errno == EAGAIN || errno == EINTR))
-        return 0;
+        return false;
     errno_assert (sz != -1);
-    return signals;
+    return true;
 }
 
 zmq::fd_t zmq::fd_signaler_t::get_fd ()
@@ -171,18 +160,17 @@ zmq::fd_signaler_t::~fd_signaler_t ()
     wsa_assert (rc != SOCKET_ERROR);
 }
 
-void zmq::fd_signaler_t::signal (int signal_)
+void zmq::fd_signaler_t::signal ()
 {
     //  TODO: Note that send is a blocking operation.
     //  How should we behave if the signal cannot be written to the signaler?
 
-    zmq_assert (signal_ >= 0 && signal_ < 64);
-    char c = (char) signal_;
+    char c = 0;
     int rc = send (w, &c, 1, 0);
     win_assert (rc != SOCKET_ERROR);
 }
 
-uint64_t zmq::fd_signaler_t::poll ()
+void zmq::fd_signaler_t::poll ()
 {
     //  Switch to blocking mode.
     unsigned long argp = 0;
@@ -191,31 +179,24 @@ uint64_t zmq::fd_signaler_t::poll ()
 
     //  Get the signals. Given that we are in the blocking mode now,
     //  there should be at least a single signal returned.
-    uint64_t signals = check ();
-    zmq_assert (signals);
+    bool signaled = check ();
+    zmq_assert (signaled);
 
     //  Switch back to non-blocking mode.
     argp = 1;
     rc = ioctlsocket (r, FIONBIO, &argp);
     wsa_assert (rc != SOCKET_ERROR);
-
-    return signals;
 }
 
-uint64_t zmq::fd_signaler_t::check ()
+bool zmq::fd_signaler_t::check ()
 {
+    //  Several signals may be pending. Drain them all at once.
     unsigned char buffer [32];
     int nbytes = recv (r, (char*) buffer, 32, 0);
     if (nbytes == -1 && WSAGetLastError () == WSAEWOULDBLOCK)
-        return 0;
+        return false;
     wsa_assert (nbytes != -1);
-
-    uint64_t signals = 0;
-    for (int pos = 0; pos != nbytes; pos++) {
-        zmq_assert (buffer [pos] < 64);
-        signals |= (uint64_t (1) << (buffer [pos]));
-    }
-    return signals;
+    return nbytes > 0;
 }
 
 zmq::fd_t zmq::fd_signaler_t::get_fd ()
@@ -227,6 +208,7 @@ zmq::fd_t zmq::fd_signaler_t::get_fd ()
 
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <poll.h>
 
 zmq::fd_signaler_t::fd_signaler_t ()
 {
@@ -250,50 +232,40 @@ zmq::fd_signaler_t::~fd_signaler_t ()
     close (r);
 }
 
-void zmq::fd_signaler_t::signal (int signal_)
+void zmq::fd_signaler_t::signal ()
 {
-    zmq_assert (signal_ >= 0 && signal_ < 64);
-    unsigned char c = (unsigned char) signal_;
+    unsigned char c = 0;
     ssize_t nbytes = send (w, &c, 1, 0);
     errno_assert (nbytes == 1);
 }
 
-uint64_t zmq::fd_signaler_t::poll ()
+void zmq::fd_signaler_t::poll ()
 {
-    //  Set the reader to blocking mode.
-    int flags = fcntl (r, F_GETFL, 0);
-    if (flags == -1)
-        flags = 0;
-    int rc = fcntl (r, F_SETFL, flags & ~O_NONBLOCK);
-    errno_assert (rc != -1);
-
-    //  Poll for events.
-    uint64_t signals = check ();
-
-    //  Set the reader to non-blocking mode.
-    flags = fcntl (r, F_GETFL, 0);
-    if (flags == -1)
-        flags = 0;
-    rc = fcntl (r, F_SETFL, flags | O_NONBLOCK);
+    //  Wait for the reader to become readable. It stays in non-blocking
+    //  mode all the time so that there's no need to switch it to blocking
+    //  mode and back on each wait.
+    pollfd pfd;
+    pfd.fd = r;
+    pfd.events = POLLIN;
+    int rc;
+    do {
+        rc = ::poll (&pfd, 1, -1);
+    } while (rc == -1 && errno == EINTR);
     errno_assert (rc != -1);
 
-    return signals;
+    bool signaled = check ();
+    zmq_assert (signaled);
 }
 
-uint64_t zmq::fd_signaler_t::check ()
+bool zmq::fd_signaler_t::check ()
 {
+    //  Several signals may be pending. Drain them all at once.
     unsigned char buffer [64];
     ssize_t nbytes = recv (r, buffer, 64, 0);
     if (nbytes == -1 && errno == EAGAIN)
-        return 0;
+        return false;
     zmq_assert (nbytes != -1);
-
-    uint64_t signals = 0;
-    for (int pos = 0; pos != nbytes; pos ++) {
-        zmq_assert (buffer [pos] < 64);
-        signals |= (uint64_t (1) << (buffer [pos]));
-    }
-    return signals;
+    return nbytes > 0;
 }
 
 zmq::fd_t zmq::fd_signaler_t::get_fd ()
@@ -321,45 +293,33 @@ zmq::fd_signaler_t::~fd_signaler_t ()
     close (r);
 }
 
-void zmq::fd_signaler_t::signal (int signal_)
+void zmq::fd_signaler_t::signal ()
 {
     //  TODO: Note that send is a blocking operation.
     //  How should we behave if the signal cannot be written to the signaler?
 
-    zmq_assert (signal_ >= 0 && signal_ < 64);
-    unsigned char c = (unsigned char) signal_;
+    unsigned char c = 0;
     ssize_t nbytes = send (w, &c, 1, 0);
     errno_assert (nbytes == 1);
 }
 
-uint64_t zmq::fd_signaler_t::poll ()
+void zmq::fd_signaler_t::poll ()
 {
+    //  Several signals may be pending. Drain them all at once.
     unsigned char buffer [64];
     ssize_t nbytes = recv (r, buffer, 64, 0);
-    zmq_assert (nbytes != -1);
-
-    uint64_t signals = 0;
-    for (int pos = 0; pos != nbytes; pos ++) {
-        zmq_assert (buffer [pos] < 64);
-        signals |= (uint64_t (1) << (buffer [pos]));
-    }
-    return signals;
+    zmq_assert (nbytes > 0);
 }
 
-uint64_t zmq::fd_signaler_t::check ()
+bool zmq::fd_signaler_t::check ()
 {
+    //  Several signals may be pending. Drain them all at once.
     unsigned char buffer [64];
     ssize_t nbytes = recv (r, buffer, 64, MSG_DONTWAIT);
     if (nbytes == -1 && errno == EAGAIN)
-        return 0;
+        return false;
     zmq_assert (nbytes != -1);
-
-    uint64_t signals = 0;
-    for (int pos = 0; pos != nbytes; pos ++) {
-        zmq_assert (buffer [pos] < 64);
-        signals |= (uint64_t (1) << (buffer [pos]));
-    }
-    return signals;
+    return nbytes > 0;
 }
 
 zmq::fd_t zmq::fd_signaler_t::get_fd ()
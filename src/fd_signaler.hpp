@@ -28,10 +28,9 @@
 namespace zmq
 {
 
-    //  This object can be used to send individual signals from one thread to
-    //  another. The specific of this pipe is that it has associated file
-    //  descriptor and so it can be polled on. Same signal cannot be sent twice
-    //  unless signals are retrieved by the reader side in the meantime.
+    //  This object can be used to send signals from one thread to another.
+    //  The specific of this pipe is that it has associated file descriptor
+    //  and so it can be polled on.
 
     class fd_signaler_t : public i_signaler
     {
@@ -41,9 +40,9 @@ namespace zmq
         ~fd_signaler_t ();
 
         //  i_signaler interface implementation.
-        void signal (int signal_);
-        uint64_t poll ();
-        uint64_t check ();
+        void signal ();
+        void poll ();
+        bool check ();
         fd_t get_fd ();
 
     private:
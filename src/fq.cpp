@@ -39,7 +39,9 @@ zmq::fq_t::~fq_t ()
 void zmq::fq_t::attach (reader_t *pipe_)
 {
     pipes.push_back (pipe_);
+    drr.push_back ();
     pipes.swap (active, pipes.size () - 1);
+    drr.swap (active, pipes.size () - 1);
     active++;
 }
 
@@ -47,14 +49,21 @@ void zmq::fq_t::detach (reader_t *pipe_)
 {
     zmq_assert (!more || pipes [current] != pipe_);
 
-    //  Remove the pipe from the list; adjust number of active pipes
-    //  accordingly.
-    if (pipes.index (pipe_) < active) {
+    //  Move the pipe to the list of inactive pipes first so that removing
+    //  it doesn't move an inactive pipe among the active ones.
+    pipes_t::size_type index = pipes.index (pipe_);
+    if (index < active) {
         active--;
         if (current == active)
             current = 0;
+        pipes.swap (index, active);
+        drr.swap (index, active);
+        index = active;
     }
-    pipes.erase (pipe_);
+
+    //  Remove the pipe from the list.
+    pipes.erase (index);
+    drr.erase (index);
 }
 
 void zmq::fq_t::kill (reader_t *pipe_)
@@ -63,13 +72,18 @@ void zmq::fq_t::kill (reader_t *pipe_)
     active--;
     if (current == active)
         current = 0;
-    pipes.swap (pipes.index (pipe_), active);
+    pipes_t::size_type index = pipes.index (pipe_);
+    pipes.swap (index, active);
+    drr.swap (index, active);
+    drr.deactivate (active);
 }
 
 void zmq::fq_t::revive (reader_t *pipe_)
 {
     //  Move the pipe to the list of active pipes.
-    pipes.swap (pipes.index (pipe_), active);
+    pipes_t::size_type index = pipes.index (pipe_);
+    pipes.swap (index, active);
+    drr.swap (index, active);
     active++;
 }
 
@@ -78,6 +92,9 @@ int zmq::fq_t::recv (zmq_msg_t *msg_, int flags_)
     //  Deallocate old content of the message.
     zmq_msg_close (msg_);
 
+    if (drr.enabled ())
+        return recv_deficit (msg_);
+
     //  Round-robin over the pipes to get the next message.
     for (int count = active; count != 0; count--) {
 
@@ -107,12 +124,59 @@ int zmq::fq_t::recv (zmq_msg_t *msg_, int flags_)
     return -1;
 }
 
+int zmq::fq_t::recv_deficit (zmq_msg_t *msg_)
+{
+    //  Number of pipes in a row that were found to have no credit.
+    pipes_t::size_type skipped = 0;
+
+    //  Note that every failed read deactivates a pipe, so the loop ends
+    //  once there are no more messages to read.
+    while (active) {
+
+        //  If the current pipe has used up its credit, pass the turn to the
+        //  next pipe and credit it with the quantum. Subsequent parts of
+        //  a multipart message are read irrespective of the credit so that
+        //  messages from different pipes never get interleaved.
+        if (!more && !drr.has_credit (current)) {
+            drr.pass_turn (current, active, skipped);
+            continue;
+        }
+
+        //  Note that when message is not fetched, current pipe is killed and
+        //  replaced by another active pipe.
+        skipped = 0;
+        bool fetched = pipes [current]->read (msg_);
+        zmq_assert (!(more && !fetched));
+        if (fetched) {
+            drr.charge (current, zmq_msg_size (msg_));
+            more = msg_->flags & ZMQ_MSG_MORE;
+            return 0;
+        }
+    }
+
+    //  No message is available. Initialise the output parameter
+    //  to be a 0-byte message.
+    zmq_msg_init (msg_);
+    errno = EAGAIN;
+    return -1;
+}
+
 bool zmq::fq_t::has_in ()
 {
     //  There are subsequent parts of the partly-read message available.
     if (more)
         return true;
 
+    //  With deficit round robin the turn can't be passed to another pipe
+    //  as the current pipe may have credit left. Pipes with no messages
+    //  are deactivated and replaced by other active pipes though.
+    if (drr.enabled ()) {
+        while (active)
+            if (pipes [current]->check_read ())
+                return true;
+        return false;
+    }
+
     //  Note that messing with current doesn't break the fairness of fair
     //  queueing algorithm. If there are no messages available current will
     //  get back to its original value. Otherwise it'll point to the first
@@ -128,3 +192,7 @@ bool zmq::fq_t::has_in ()
     return false;
 }
 
+int zmq::fq_t::set_quantum (const void *optval_, size_t optvallen_)
+{
+    return drr.set_quantum (optval_, optvallen_);
+}
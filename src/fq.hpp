@@ -21,13 +21,16 @@
 #define __ZMQ_FQ_HPP_INCLUDED__
 
 #include "yarray.hpp"
+#include "drr.hpp"
 
 namespace zmq
 {
 
     //  Class manages a set of inbound pipes. On receive it performs fair
     //  queueing (RFC970) so that senders gone berserk won't cause denial of
-    //  service for decent senders.
+    //  service for decent senders. Optionally, the pipes are served using
+    //  deficit round robin so that the share of each sender is measured
+    //  in bytes rather than in messages.
     class fq_t
     {
     public:
@@ -42,8 +45,16 @@ namespace zmq
         int recv (zmq_msg_t *msg_, int flags_);
         bool has_in ();
 
+        //  Sets the number of bytes each pipe is credited with per round
+        //  (ZMQ_QUANTUM socket option). Zero means that the pipes take
+        //  turns message by message.
+        int set_quantum (const void *optval_, size_t optvallen_);
+
     private:
 
+        //  Receives a message using deficit round robin.
+        int recv_deficit (zmq_msg_t *msg_);
+
         //  Inbound pipes.
         typedef yarray_t <class reader_t> pipes_t;
         pipes_t pipes;
@@ -59,6 +70,10 @@ namespace zmq
         //  there are following parts still waiting in the current pipe.
         bool more;
 
+        //  Credits of the pipes for deficit round robin. A pipe is read
+        //  from while its credit is positive.
+        drr_t drr;
+
         fq_t (const fq_t&);
         void operator = (const fq_t&);
     };
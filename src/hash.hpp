@@ -0,0 +1,46 @@
+/*
+    Copyright (c) 2007-2010 iMatix Corporation
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the Lesser GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    Lesser GNU General Public License for more details.
+
+    You should have received a copy of the Lesser GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef __ZMQ_HASH_HPP_INCLUDED__
+#define __ZMQ_HASH_HPP_INCLUDED__
+
+#include <stddef.h>
+
+#include "stdint.hpp"
+
+namespace zmq
+{
+
+    //  32-bit FNV-1a hash of the data. Different seeds yield different
+    //  hash functions.
+    inline uint32_t fnv_hash (const unsigned char *data_, size_t size_,
+        uint32_t seed_ = 0)
+    {
+        uint32_t h = 2166136261u ^ seed_;
+        for (size_t i = 0; i != size_; i++) {
+            h ^= data_ [i];
+            h *= 16777619u;
+        }
+        return h;
+    }
+
+}
+
+#endif
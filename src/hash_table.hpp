@@ -0,0 +1,184 @@
+/*
+    Copyright (c) 2007-2010 iMatix Corporation
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the Lesser GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    Lesser GNU General Public License for more details.
+
+    You should have received a copy of the Lesser GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef __ZMQ_HASH_TABLE_HPP_INCLUDED__
+#define __ZMQ_HASH_TABLE_HPP_INCLUDED__
+
+#include <stddef.h>
+#include <vector>
+
+#include "stdint.hpp"
+
+namespace zmq
+{
+
+    //  Open-addressing hash table with linear probing. The table stores
+    //  only the hash of the key and the value. Keys are kept by the user
+    //  and compared using the predicate passed to 'find', which is called
+    //  with the candidate values. Value T () marks an empty slot, thus it
+    //  can't be stored in the table.
+
+    template <typename T> class hash_table_t
+    {
+    public:
+
+        inline hash_table_t () :
+            count (0)
+        {
+        }
+
+        inline ~hash_table_t ()
+        {
+        }
+
+        //  Returns the value with the specified hash the predicate holds
+        //  for. If there's no such value, returns T ().
+        template <typename P> inline T find (uint32_t hash_, const P &pred_)
+        {
+            if (!count)
+                return T ();
+            size_t mask = slots.size () - 1;
+            for (size_t i = hash_ & mask; slots [i].value != T ();
+                  i = (i + 1) & mask)
+                if (slots [i].hash == hash_ && pred_ (slots [i].value))
+                    return slots [i].value;
+            return T ();
+        }
+
+        //  Stores the value. It's up to the caller not to store the same
+        //  key twice.
+        inline void insert (uint32_t hash_, T value_)
+        {
+            //  Keep at least a half of the slots empty so that the probe
+            //  sequences stay short.
+            if ((count + 1) * 2 > slots.size ())
+                resize (slots.empty () ? 16 : slots.size () * 2);
+
+            size_t mask = slots.size () - 1;
+            size_t i = hash_ & mask;
+            while (slots [i].value != T ())
+                i = (i + 1) & mask;
+            slots [i].hash = hash_;
+            slots [i].value = value_;
+            count++;
+        }
+
+        //  Removes the value stored with the specified hash. Returns false
+        //  if there's no such value in the table.
+        inline bool erase (uint32_t hash_, T value_)
+        {
+            size_t hole = locate (hash_, value_);
+            if (hole == slots.size ())
+                return false;
+
+            //  Rather than leaving a tombstone, move the following entries
+            //  of the probe sequence back into the hole if their home slot
+            //  allows it.
+            size_t mask = slots.size () - 1;
+            for (size_t i = (hole + 1) & mask; slots [i].value != T ();
+                  i = (i + 1) & mask) {
+                size_t home = slots [i].hash & mask;
+                if (((i - home) & mask) >= ((i - hole) & mask)) {
+                    slots [hole] = slots [i];
+                    hole = i;
+                }
+            }
+            slots [hole].value = T ();
+            count--;
+            return true;
+        }
+
+        //  Replaces the value stored with the specified hash by a new one.
+        //  Returns false if there's no such value in the table.
+        inline bool replace (uint32_t hash_, T old_, T new_)
+        {
+            size_t i = locate (hash_, old_);
+            if (i == slots.size ())
+                return false;
+            slots [i].value = new_;
+            return true;
+        }
+
+        inline bool empty ()
+        {
+            return !count;
+        }
+
+        inline void clear ()
+        {
+            slots.clear ();
+            count = 0;
+        }
+
+    private:
+
+        //  Returns the slot holding the value or the number of slots
+        //  if the value is not in the table.
+        inline size_t locate (uint32_t hash_, T value_)
+        {
+            if (!count)
+                return slots.size ();
+            size_t mask = slots.size () - 1;
+            for (size_t i = hash_ & mask; slots [i].value != T ();
+                  i = (i + 1) & mask)
+                if (slots [i].value == value_)
+                    return i;
+            return slots.size ();
+        }
+
+        //  Reallocates the table to the specified number of slots, which
+        //  has to be a power of two.
+        inline void resize (size_t capacity_)
+        {
+            slot_t empty = {0, T ()};
+            std::vector <slot_t> old_slots (capacity_, empty);
+            slots.swap (old_slots);
+
+            size_t mask = slots.size () - 1;
+            for (size_t i = 0; i != old_slots.size (); i++) {
+                if (old_slots [i].value == T ())
+                    continue;
+                size_t slot = old_slots [i].hash & mask;
+                while (slots [slot].value != T ())
+                    slot = (slot + 1) & mask;
+                slots [slot] = old_slots [i];
+            }
+        }
+
+        struct slot_t
+        {
+            uint32_t hash;
+            T value;
+        };
+
+        //  Slots of the table. The number of slots is a power of two and
+        //  at least a half of them is always empty.
+        std::vector <slot_t> slots;
+
+        //  Number of values in the table.
+        size_t count;
+
+        hash_table_t (const hash_table_t&);
+        void operator = (const hash_table_t&);
+    };
+
+}
+
+#endif
@@ -36,8 +36,9 @@ namespace zmq
         // Called by I/O thread when file descriptor is ready for writing.
         virtual void out_event () = 0;
  
-        // Called when timer expires.
-        virtual void timer_event () = 0;
+        // Called when timer expires. id_ is the identifier the timer
+        // was registered with.
+        virtual void timer_event (int id_) = 0;
     };
  
 }
@@ -25,24 +25,24 @@
 
 namespace zmq
 {
-    //  Virtual interface used to send signals. Individual implementations
-    //  may restrict the number of possible signal types to send.
+    //  Virtual interface used to wake up a thread. Signal carries no
+    //  information about its sender, so the number of threads signaling
+    //  the same signaler is unlimited. Several signals sent before the
+    //  receiver gets to them may be collapsed into a single one.
 
     struct i_signaler
     {
         virtual ~i_signaler () {};
 
-        //  Send a signal with a specific ID.
-        virtual void signal (int signal_) = 0;
+        //  Send a signal.
+        virtual void signal () = 0;
 
-        //  Wait for signal. Returns a set of signals in form of a bitmap.
-        //  Signal with index 0 corresponds to value 1, index 1 to value 2,
-        //  index 2 to value 3 etc.
-        virtual uint64_t poll () = 0;
+        //  Wait for a signal. Returns after at least one signal was received.
+        virtual void poll () = 0;
 
         //  Same as poll, however, if there is no signal available,
-        //  function returns zero immediately instead of waiting for a signal.
-        virtual uint64_t check () = 0;
+        //  function returns false immediately instead of waiting for a signal.
+        virtual bool check () = 0;
 
         //  Returns file descriptor that allows waiting for signals. Specific
         //  signalers may not support this functionality. If so, the function
@@ -66,14 +66,15 @@ void zmq::io_object_t::reset_pollout (handle_t handle_)
     poller->reset_pollout (handle_);
 }
 
-void zmq::io_object_t::add_timer ()
+zmq::io_object_t::timer_handle_t zmq::io_object_t::add_timer (int timeout_,
+    int id_)
 {
-    poller->add_timer (this);
+    return poller->add_timer (timeout_, this, id_);
 }
 
-void zmq::io_object_t::cancel_timer ()
+void zmq::io_object_t::cancel_timer (timer_handle_t handle_)
 {
-    poller->cancel_timer (this);
+    poller->cancel_timer (handle_);
 }
 
 void zmq::io_object_t::in_event ()
@@ -86,7 +87,7 @@ void zmq::io_object_t::out_event ()
     zmq_assert (false);
 }
 
-void zmq::io_object_t::timer_event ()
+void zmq::io_object_t::timer_event (int id_)
 {
     zmq_assert (false);
 }
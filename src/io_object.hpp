@@ -25,6 +25,7 @@
 #include "stdint.hpp"
 #include "poller.hpp"
 #include "i_poll_events.hpp"
+#include "timer_wheel.hpp"
 
 namespace zmq
 {
@@ -43,6 +44,7 @@ namespace zmq
     protected:
 
         typedef poller_t::handle_t handle_t;
+        typedef timer_wheel_t::handle_t timer_handle_t;
 
         //  Derived class can init/swap the underlying I/O thread.
         //  Caution: Remove all the file descriptors from the old I/O thread
@@ -56,13 +58,13 @@ namespace zmq
         void reset_pollin (handle_t handle_);
         void set_pollout (handle_t handle_);
         void reset_pollout (handle_t handle_);
-        void add_timer ();
-        void cancel_timer ();
+        timer_handle_t add_timer (int timeout_, int id_);
+        void cancel_timer (timer_handle_t handle_);
 
         //  i_poll_events interface implementation.
         void in_event ();
         void out_event ();
-        void timer_event ();
+        void timer_event (int id_);
 
     private:
 
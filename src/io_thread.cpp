@@ -31,7 +31,8 @@
 
 zmq::io_thread_t::io_thread_t (dispatcher_t *dispatcher_, int thread_slot_,
       int flags_) :
-    object_t (dispatcher_, thread_slot_)
+    object_t (dispatcher_, thread_slot_),
+    mailbox (&signaler)
 {
     poller = new (std::nothrow) poller_t;
     zmq_assert (poller);
@@ -61,6 +62,11 @@ zmq::i_signaler *zmq::io_thread_t::get_signaler ()
     return &signaler;
 }
 
+zmq::mailbox_t *zmq::io_thread_t::get_mailbox ()
+{
+    return &mailbox;
+}
+
 int zmq::io_thread_t::get_load ()
 {
     return poller->get_load ();
@@ -68,23 +74,14 @@ int zmq::io_thread_t::get_load ()
 
 void zmq::io_thread_t::in_event ()
 {
-    //  Find out which threads are sending us commands.
-    uint64_t signals = signaler.check ();
-    zmq_assert (signals);
-
-    //  Iterate through all the threads in the process and find out
-    //  which of them sent us commands.
-    int slot_count = thread_slot_count ();
-    for (int source_thread_slot = 0;
-          source_thread_slot != slot_count; source_thread_slot++) {
-        if (signals & (uint64_t (1) << source_thread_slot)) {
-
-            //  Read all the commands from particular thread.
-            command_t cmd;
-            while (dispatcher->read (source_thread_slot, thread_slot, &cmd))
-                cmd.destination->process_command (cmd);
-        }
-    }
+    //  Reset the signaler.
+    bool signaled = signaler.check ();
+    zmq_assert (signaled);
+
+    //  Process all the commands available in the mailbox.
+    command_t cmd;
+    while (mailbox.recv (&cmd))
+        cmd.destination->process_command (cmd);
 }
 
 void zmq::io_thread_t::out_event ()
@@ -93,7 +90,7 @@ void zmq::io_thread_t::out_event ()
     zmq_assert (false);
 }
 
-void zmq::io_thread_t::timer_event ()
+void zmq::io_thread_t::timer_event (int id_)
 {
     //  No timers here. This function is never called.
     zmq_assert (false);
@@ -27,6 +27,7 @@
 #include "poller.hpp"
 #include "i_poll_events.hpp"
 #include "fd_signaler.hpp"
+#include "mailbox.hpp"
 
 namespace zmq
 {
@@ -54,10 +55,13 @@ namespace zmq
         //  Returns signaler associated with this I/O thread.
         i_signaler *get_signaler ();
 
+        //  Returns mailbox associated with this I/O thread.
+        mailbox_t *get_mailbox ();
+
         //  i_poll_events implementation.
         void in_event ();
         void out_event ();
-        void timer_event ();
+        void timer_event (int id_);
 
         //  Used by io_objects to retrieve the assciated poller object.
         poller_t *get_poller ();
@@ -74,6 +78,10 @@ namespace zmq
         //  this signaler.
         fd_signaler_t signaler;
 
+        //  Mailbox to receive commands from other threads. Note that it has
+        //  to be declared after the signaler as it uses it.
+        mailbox_t mailbox;
+
         //  Handle associated with signaler's file descriptor.
         poller_t::handle_t signaler_handle;
 
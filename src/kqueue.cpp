@@ -132,16 +132,15 @@ void zmq::kqueue_t::reset_pollout (handle_t handle_)
     kevent_delete (pe->fd, EVFILT_WRITE);
 }
 
-void zmq::kqueue_t::add_timer (i_poll_events *events_)
+zmq::timer_wheel_t::handle_t zmq::kqueue_t::add_timer (int timeout_,
+    i_poll_events *events_, int id_)
 {
-     timers.push_back (events_);
+    return timers.add (timeout_, events_, id_);
 }
 
-void zmq::kqueue_t::cancel_timer (i_poll_events *events_)
+void zmq::kqueue_t::cancel_timer (timer_wheel_t::handle_t handle_)
 {
-    timers_t::iterator it = std::find (timers.begin (), timers.end (), events_);
-    if (it != timers.end ())
-        timers.erase (it);
+    timers.cancel (handle_);
 }
 
 int zmq::kqueue_t::get_load ()
@@ -165,32 +164,17 @@ void zmq::kqueue_t::loop ()
 
         struct kevent ev_buf [max_io_events];
 
-        //  Compute time interval to wait.
-        timespec timeout = {max_timer_period / 1000,
-            (max_timer_period % 1000) * 1000000};
+        //  Execute any due timers and compute time interval to wait.
+        int ms = timers.execute ();
+        timespec timeout = {ms / 1000, (ms % 1000) * 1000000};
 
         //  Wait for events.
         int n = kevent (kqueue_fd, NULL, 0,
-             &ev_buf [0], max_io_events, timers.empty () ? NULL : &timeout);
+             &ev_buf [0], max_io_events, ms == -1 ? NULL : &timeout);
         if (n == -1 && errno == EINTR)
             continue;
         errno_assert (n != -1);
 
-        //  Handle timer.
-        if (!n) {
-
-            //  Use local list of timers as timer handlers may fill new timers
-            //  into the original array.
-            timers_t t;
-            std::swap (timers, t);
-
-            //  Trigger all the timers.
-            for (timers_t::iterator it = t.begin (); it != t.end (); it ++)
-                (*it)->timer_event ();
-
-            continue;
-        }
-
         for (int i = 0; i < n; i ++) {
             poll_entry_t *pe = (poll_entry_t*) ev_buf [i].udata;
 
@@ -30,6 +30,7 @@
 #include "fd.hpp"
 #include "thread.hpp"
 #include "atomic_counter.hpp"
+#include "timer_wheel.hpp"
 
 namespace zmq
 {
@@ -53,8 +54,9 @@ namespace zmq
         void reset_pollin (handle_t handle_);
         void set_pollout (handle_t handle_);
         void reset_pollout (handle_t handle_);
-        void add_timer (struct i_poll_events *events_);
-        void cancel_timer (struct i_poll_events *events_);
+        timer_wheel_t::handle_t add_timer (int timeout_,
+            struct i_poll_events *events_, int id_);
+        void cancel_timer (timer_wheel_t::handle_t handle_);
         int get_load ();
         void start ();
         void stop ();
@@ -88,9 +90,8 @@ namespace zmq
         typedef std::vector <poll_entry_t*> retired_t;
         retired_t retired;
 
-        //  List of all the engines waiting for the timer event.
-        typedef std::vector <struct i_poll_events*> timers_t;
-        timers_t timers;
+        //  Timers registered with the poller.
+        timer_wheel_t timers;
 
         //  If true, thread is in the process of shutting down.
         bool stopping;
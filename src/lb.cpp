@@ -17,16 +17,46 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <string.h>
+#include <algorithm>
+
 #include "../include/zmq.h"
 
 #include "lb.hpp"
+#include "socket_base.hpp"
 #include "pipe.hpp"
+#include "config.hpp"
+#include "hash.hpp"
 #include "err.hpp"
 
+//  Hashes the data (FNV-1a followed by Murmur3 finalizer so that similar
+//  inputs end up far from each other on the ring).
+static uint32_t ring_hash (const unsigned char *data_, size_t size_,
+    uint32_t seed_)
+{
+    uint32_t h = zmq::fnv_hash (data_, size_, seed_);
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
+}
+
+struct point_less_t
+{
+    template <typename T> bool operator () (const T &a_, const T &b_) const
+    {
+        return a_.hash < b_.hash;
+    }
+};
+
 zmq::lb_t::lb_t () :
     active (0),
     current (0),
-    more (false)
+    more (false),
+    balance (ZMQ_BALANCE_ROUND_ROBIN),
+    key_size (0)
 {
 }
 
@@ -36,11 +66,29 @@ zmq::lb_t::~lb_t ()
         pipes [i]->term ();
 }
 
-void zmq::lb_t::attach (writer_t *pipe_)
+void zmq::lb_t::attach (writer_t *pipe_, const blob_t &peer_identity_)
 {
     pipes.push_back (pipe_);
     pipes.swap (active, pipes.size () - 1);
     active++;
+
+    //  Place the pipe on the consistent-hash ring. Peers with identity keep
+    //  their positions across reconnections. Anonymous peers are placed
+    //  according to the pipe itself.
+    const unsigned char *seed = peer_identity_.data ();
+    size_t seed_size = peer_identity_.size ();
+    if (!seed_size) {
+        seed = (const unsigned char*) &pipe_;
+        seed_size = sizeof (pipe_);
+    }
+    ring_t::size_type old_size = ring.size ();
+    for (uint32_t i = 0; i != consistent_hash_points; i++) {
+        point_t point = {ring_hash (seed, seed_size, i), pipe_};
+        ring.push_back (point);
+    }
+    std::sort (ring.begin () + old_size, ring.end (), point_less_t ());
+    std::inplace_merge (ring.begin (), ring.begin () + old_size, ring.end (),
+        point_less_t ());
 }
 
 void zmq::lb_t::detach (writer_t *pipe_)
@@ -55,6 +103,14 @@ void zmq::lb_t::detach (writer_t *pipe_)
             current = 0;
     }
     pipes.erase (pipe_);
+
+    //  Remove the pipe from the ring. Its keys are taken over by the pipes
+    //  owning the following points.
+    ring_t::size_type pos = 0;
+    for (ring_t::size_type i = 0; i != ring.size (); i++)
+        if (ring [i].pipe != pipe_)
+            ring [pos++] = ring [i];
+    ring.resize (pos);
 }
 
 void zmq::lb_t::revive (writer_t *pipe_)
@@ -66,6 +122,12 @@ void zmq::lb_t::revive (writer_t *pipe_)
 
 int zmq::lb_t::send (zmq_msg_t *msg_, int flags_)
 {
+    //  Subsequent parts of a message go to the same pipe as the first one.
+    if (balance == ZMQ_BALANCE_KEY_HASH && !more)
+        return send_keyed (msg_, flags_);
+    if (balance == ZMQ_BALANCE_LEAST_QUEUED && !more && active > 1)
+        choose_least_queued ();
+
     while (active > 0) {
         if (pipes [current]->write (msg_)) {
             more = msg_->flags & ZMQ_MSG_MORE;
@@ -73,11 +135,7 @@ int zmq::lb_t::send (zmq_msg_t *msg_, int flags_)
         }
 
         zmq_assert (!more);
-        active--;
-        if (current < active)
-            pipes.swap (current, active);
-        else
-            current = 0;
+        kill_current ();
     }
 
     //  If there are no pipes we cannot send the message.
@@ -89,7 +147,8 @@ int zmq::lb_t::send (zmq_msg_t *msg_, int flags_)
     //  If it's final part of the message we can fluch it downstream and
     //  continue round-robinning (load balance).
     if (!more) {
-        pipes [current]->flush ();
+        if (!(flags_ & send_noflush))
+            pipes [current]->flush ();
         current = (current + 1) % active;
     }
 
@@ -111,13 +170,113 @@ bool zmq::lb_t::has_out ()
         if (pipes [current]->check_write ())
             return true;
 
-        active--;
-        if (current < active)
-            pipes.swap (current, active);
-        else
-            current = 0;
+        kill_current ();
     }
 
     return false;
 }
 
+void zmq::lb_t::flush ()
+{
+    //  Inactive pipes may hold messages written before they got full.
+    for (pipes_t::size_type i = 0; i != pipes.size (); i++)
+        pipes [i]->flush ();
+}
+
+int zmq::lb_t::set_balance (const void *optval_, size_t optvallen_)
+{
+    if (optvallen_ != sizeof (int64_t)) {
+        errno = EINVAL;
+        return -1;
+    }
+    int64_t balance_ = *((int64_t*) optval_);
+    if (balance_ != ZMQ_BALANCE_ROUND_ROBIN &&
+          balance_ != ZMQ_BALANCE_LEAST_QUEUED &&
+          balance_ != ZMQ_BALANCE_KEY_HASH) {
+        errno = EINVAL;
+        return -1;
+    }
+    balance = balance_;
+    return 0;
+}
+
+int zmq::lb_t::set_key_size (const void *optval_, size_t optvallen_)
+{
+    if (optvallen_ != sizeof (uint64_t)) {
+        errno = EINVAL;
+        return -1;
+    }
+    key_size = *((uint64_t*) optval_);
+    return 0;
+}
+
+int zmq::lb_t::send_keyed (zmq_msg_t *msg_, int flags_)
+{
+    if (ring.empty ()) {
+        errno = EAGAIN;
+        return -1;
+    }
+
+    //  Find the pipe owning the key.
+    size_t size = zmq_msg_size (msg_);
+    if (key_size && key_size < size)
+        size = (size_t) key_size;
+    point_t key = {ring_hash ((unsigned char*) zmq_msg_data (msg_), size, 0),
+        NULL};
+    ring_t::iterator it = std::upper_bound (ring.begin (), ring.end (), key,
+        point_less_t ());
+    if (it == ring.end ())
+        it = ring.begin ();
+
+    //  The message is never redirected to a different pipe. If the pipe is
+    //  full, wait till it is revived.
+    pipes_t::size_type index = pipes.index (it->pipe);
+    if (index >= active) {
+        errno = EAGAIN;
+        return -1;
+    }
+    current = index;
+    if (!pipes [current]->write (msg_)) {
+        kill_current ();
+        errno = EAGAIN;
+        return -1;
+    }
+
+    more = msg_->flags & ZMQ_MSG_MORE;
+    if (!more && !(flags_ & send_noflush))
+        pipes [current]->flush ();
+
+    //  Detach the message from the data buffer.
+    int rc = zmq_msg_init (msg_);
+    zmq_assert (rc == 0);
+
+    return 0;
+}
+
+void zmq::lb_t::choose_least_queued ()
+{
+    //  The search starts at the current pipe so that pipes with equal queues
+    //  are still used in round-robin fashion.
+    pipes_t::size_type best = current;
+    uint64_t best_size = pipes [current]->queue_size ();
+    for (pipes_t::size_type i = current + 1; best_size && i != active; i++)
+        if (pipes [i]->queue_size () < best_size) {
+            best = i;
+            best_size = pipes [i]->queue_size ();
+        }
+    for (pipes_t::size_type i = 0; best_size && i != current; i++)
+        if (pipes [i]->queue_size () < best_size) {
+            best = i;
+            best_size = pipes [i]->queue_size ();
+        }
+    current = best;
+}
+
+void zmq::lb_t::kill_current ()
+{
+    active--;
+    if (current < active)
+        pipes.swap (current, active);
+    else
+        current = 0;
+}
@@ -20,7 +20,13 @@
 #ifndef __ZMQ_LB_HPP_INCLUDED__
 #define __ZMQ_LB_HPP_INCLUDED__
 
+#include <vector>
+
+#include "../include/zmq.h"
+
 #include "yarray.hpp"
+#include "blob.hpp"
+#include "stdint.hpp"
 
 namespace zmq
 {
@@ -34,14 +40,36 @@ namespace zmq
         lb_t ();
         ~lb_t ();
 
-        void attach (class writer_t *pipe_);
+        //  Identity of the peer determines the position of the pipe
+        //  on the consistent-hash ring.
+        void attach (class writer_t *pipe_, const blob_t &peer_identity_);
         void detach (class writer_t *pipe_);
         void revive (class writer_t *pipe_);
         int send (zmq_msg_t *msg_, int flags_);
         bool has_out ();
 
+        //  Flushes the messages sent with send_noflush flag.
+        void flush ();
+
+        //  Sets the load-balancing policy (ZMQ_BALANCE socket option).
+        int set_balance (const void *optval_, size_t optvallen_);
+
+        //  Sets the number of bytes at the beginning of the message used
+        //  as a key by consistent hashing (ZMQ_BALANCE_KEY_SIZE option).
+        int set_key_size (const void *optval_, size_t optvallen_);
+
     private:
 
+        //  Sends the message to the pipe owning the message's key on
+        //  the consistent-hash ring.
+        int send_keyed (zmq_msg_t *msg_, int flags_);
+
+        //  Chooses the pipe with the fewest messages queued.
+        void choose_least_queued ();
+
+        //  Deactivates the current pipe after a failed write.
+        void kill_current ();
+
         //  List of outbound pipes.
         typedef yarray_t <class writer_t> pipes_t;
         pipes_t pipes;
@@ -56,6 +84,24 @@ namespace zmq
         //  True if last we are in the middle of a multipart message.
         bool more;
 
+        //  Load-balancing policy, one of ZMQ_BALANCE_* values.
+        int64_t balance;
+
+        //  Number of bytes of the message used as the key by consistent
+        //  hashing. Zero means the whole first part of the message.
+        uint64_t key_size;
+
+        //  Consistent-hash ring. Each pipe is represented by a number of
+        //  points sorted by their hashes. A key belongs to the pipe owning
+        //  the first point following the hash of the key.
+        struct point_t
+        {
+            uint32_t hash;
+            class writer_t *pipe;
+        };
+        typedef std::vector <point_t> ring_t;
+        ring_t ring;
+
         lb_t (const lb_t&);
         void operator = (const lb_t&);
     };
@@ -0,0 +1,105 @@
+/*
+    Copyright (c) 2007-2010 iMatix Corporation
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the Lesser GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    Lesser GNU General Public License for more details.
+
+    You should have received a copy of the Lesser GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <new>
+
+#include "mailbox.hpp"
+#include "err.hpp"
+
+zmq::mailbox_t::mailbox_t (i_signaler *signaler_) :
+    retrieved (0),
+    signaler (signaler_)
+{
+    //  Queue always contains at least one node. Initially it is a dummy node
+    //  with no command attached.
+    tail = new (std::nothrow) node_t;
+    zmq_assert (tail);
+    head.set (tail);
+}
+
+zmq::mailbox_t::~mailbox_t ()
+{
+    //  Deallocate the commands that were never delivered. Note that the tail
+    //  node holds the command already retrieved by the reader.
+    while (tail) {
+        node_t *next = tail->next.cas (NULL, NULL);
+        delete tail;
+        tail = next;
+        if (tail)
+            deallocate_command (&tail->cmd);
+    }
+}
+
+void zmq::mailbox_t::send (const command_t &cmd_)
+{
+    node_t *node = new (std::nothrow) node_t;
+    zmq_assert (node);
+    node->cmd = cmd_;
+
+    //  Append the node to the queue. Exchanging the head pointer is a full
+    //  memory barrier so the command is visible to the reader before the node
+    //  is linked to its predecessor.
+    node_t *prev = head.xchg (node);
+    prev->next.set (node);
+
+    //  If the reader has drained the mailbox in the meantime, wake it up.
+    if (pending.add (1) == 0)
+        signaler->signal ();
+}
+
+bool zmq::mailbox_t::recv (command_t *cmd_)
+{
+    while (true) {
+
+        //  If the next node is already linked, retrieve the command from it.
+        //  The retired tail node is not needed any more.
+        node_t *next = tail->next.cas (NULL, NULL);
+        if (next) {
+            *cmd_ = next->cmd;
+            delete tail;
+            tail = next;
+            retrieved++;
+            return true;
+        }
+
+        //  There are no commands available. Acknowledge the ones retrieved
+        //  so far. If there are no other commands pending, the mailbox is
+        //  drained and the next writer will signal us.
+        bool more = pending.sub (retrieved);
+        retrieved = 0;
+        if (!more)
+            return false;
+
+        //  Some writer has already exchanged the head pointer, however, it
+        //  haven't linked the node yet. This is a matter of a couple of
+        //  instructions so we simply retry.
+    }
+}
+
+bool zmq::mailbox_t::has_pending ()
+{
+    //  The signal is raised only after the count goes up from zero. Note that
+    //  zero count doesn't guarantee there's no signal to be consumed. The
+    //  reader may acknowledge a command before its sender increments the
+    //  count, in which case the count goes up from zero for the next sender
+    //  and the signal is raised even though the reader retrieves both
+    //  commands straight away. Thus, this is only a hint for speculative
+    //  checks; once the signaler reports a signal, it must be consumed.
+    return pending.get () != 0;
+}
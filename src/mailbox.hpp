@@ -0,0 +1,103 @@
+/*
+    Copyright (c) 2007-2010 iMatix Corporation
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the Lesser GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    Lesser GNU General Public License for more details.
+
+    You should have received a copy of the Lesser GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_MAILBOX_HPP_INCLUDED__
+#define __ZMQ_MAILBOX_HPP_INCLUDED__
+
+#include <stddef.h>
+
+#include "i_signaler.hpp"
+#include "command.hpp"
+#include "atomic_ptr.hpp"
+#include "atomic_counter.hpp"
+
+namespace zmq
+{
+
+    //  Mailbox is a lock-free queue of commands destined for a single thread.
+    //  Any number of threads can send commands to the mailbox concurrently,
+    //  however, only the thread owning the mailbox may read from it.
+    //
+    //  The mailbox keeps count of pending commands. The signaler of the
+    //  owning thread is used only when the count goes up from zero, i.e. when
+    //  the reader has drained the mailbox and may be asleep. Thus, a busy
+    //  thread is woken up once per batch of commands, not once per sender.
+
+    class mailbox_t
+    {
+    public:
+
+        mailbox_t (struct i_signaler *signaler_);
+        ~mailbox_t ();
+
+        //  Send a command to the mailbox. This function can be called from
+        //  any thread.
+        void send (const command_t &cmd_);
+
+        //  Retrieve a command from the mailbox. Returns false if there are no
+        //  more commands. In that case the mailbox is considered drained and
+        //  the next command sent will raise a signal. This function must be
+        //  called only from the thread owning the mailbox.
+        bool recv (command_t *cmd_);
+
+        //  Returns false if the mailbox is drained, i.e. there are no
+        //  commands to be waiting for the owning thread. A stale signal may
+        //  still be raised though. This function must be called only from
+        //  the thread owning the mailbox.
+        bool has_pending ();
+
+    private:
+
+        //  Individual item of the queue. Nodes form a singly linked list
+        //  going from the oldest command to the newest one. Each node is
+        //  allocated by the sender and deallocated by the reader. Commands
+        //  are rare compared to messages (revive when the reader is asleep,
+        //  reader_info once per low watermark of messages), so unlike with
+        //  the message pipes, allocating them in batches doesn't pay off.
+        struct node_t
+        {
+            command_t cmd;
+            atomic_ptr_t <node_t> next;
+        };
+
+        //  The most recently sent node. This is the single point of
+        //  contention among the writers.
+        atomic_ptr_t <node_t> head;
+
+        //  The node most recently retrieved by the reader. Its command was
+        //  already returned, it is kept only to hold the link to the next
+        //  node. Accessed exclusively by the reader thread.
+        node_t *tail;
+
+        //  Number of commands sent but not yet acknowledged by the reader.
+        atomic_counter_t pending;
+
+        //  Number of commands retrieved since the last acknowledgement.
+        atomic_counter_t::integer_t retrieved;
+
+        //  Signaler used to wake up the reader thread.
+        struct i_signaler *signaler;
+
+        mailbox_t (const mailbox_t&);
+        void operator = (const mailbox_t&);
+    };
+
+}
+
+#endif
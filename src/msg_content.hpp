@@ -35,7 +35,8 @@ namespace zmq
     //  In the latter case, ffn member stores pointer to the function to be
     //  used to deallocate the data. If the buffer is actually shared (there
     //  are at least 2 references to it) refcount member contains number of
-    //  references.
+    //  references. If embedded is set, the structure itself is part of
+    //  the block deallocated by ffn rather than a separate allocation.
 
     struct msg_content_t
     {
@@ -44,6 +45,7 @@ namespace zmq
         zmq_free_fn *ffn;
         void *hint;
         zmq::atomic_counter_t refcnt;
+        bool embedded;
     };
 
 }
@@ -0,0 +1,306 @@
+/*
+    Copyright (c) 2007-2010 iMatix Corporation
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the Lesser GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    Lesser GNU General Public License for more details.
+
+    You should have received a copy of the Lesser GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <new>
+#include <vector>
+#include <stdlib.h>
+
+#include "platform.hpp"
+
+#if !defined ZMQ_HAVE_WINDOWS
+#include <pthread.h>
+#endif
+
+#include "msg_pool.hpp"
+#include "mutex.hpp"
+#include "likely.hpp"
+#include "err.hpp"
+
+//  Where compiler-supported thread-local variables are available, they are
+//  used to speed up the lookup of the pool. Initial-exec model avoids
+//  calling into the dynamic linker on each access. Thread-specific storage
+//  key is still needed to get notified when the thread exits.
+#if defined ZMQ_HAVE_LINUX && defined __GNUC__
+#define ZMQ_MSG_POOL_TLS
+#endif
+
+#if !defined ZMQ_HAVE_WINDOWS
+
+//  Thread-specific storage holding the pool of the calling thread.
+static pthread_key_t pool_key;
+static pthread_once_t pool_key_once = PTHREAD_ONCE_INIT;
+
+#if defined ZMQ_MSG_POOL_TLS
+static __thread void *tls_pool __attribute__ ((tls_model ("initial-exec")));
+#endif
+
+//  Pools whose owning threads have exited, waiting to be adopted.
+static std::vector <void*> orphans;
+static zmq::mutex_t orphans_sync;
+
+#endif
+
+zmq::msg_pool_t::msg_pool_t () :
+    reclaimed (NULL),
+    batch_owner (NULL),
+    batch_first (NULL),
+    batch_last (NULL),
+    batch_count (0)
+{
+    for (int i = 0; i != size_classes; i++) {
+        free_blocks [i] = NULL;
+        free_counts [i] = 0;
+
+        //  The same amount of memory is cached for each size class.
+        free_limits [i] = msg_pool_cache_size / (min_block_size << i);
+    }
+}
+
+zmq::msg_pool_t::~msg_pool_t ()
+{
+}
+
+inline zmq::msg_pool_t::block_t *&zmq::msg_pool_t::next (block_t *block_)
+{
+    return *(block_t**) (block_ + 1);
+}
+
+inline zmq::msg_pool_t *zmq::msg_pool_t::current ()
+{
+#if defined ZMQ_MSG_POOL_TLS
+    msg_pool_t *pool = (msg_pool_t*) tls_pool;
+    if (likely (pool != NULL))
+        return pool;
+#elif !defined ZMQ_HAVE_WINDOWS
+    int rc = pthread_once (&pool_key_once, create_key);
+    posix_assert (rc);
+    msg_pool_t *pool = (msg_pool_t*) pthread_getspecific (pool_key);
+    if (pool)
+        return pool;
+#endif
+    return create ();
+}
+
+inline zmq::msg_pool_t::block_t *zmq::msg_pool_t::alloc_block (
+    size_t size_class_)
+{
+    block_t *block = free_blocks [size_class_];
+    if (likely (block != NULL)) {
+        free_blocks [size_class_] = next (block);
+        free_counts [size_class_]--;
+        return block;
+    }
+    return reclaim (size_class_);
+}
+
+inline void zmq::msg_pool_t::release (block_t *block_)
+{
+    size_t size_class = block_->size_class;
+    if (unlikely (free_counts [size_class] >= free_limits [size_class])) {
+        free (block_);
+        return;
+    }
+
+    next (block_) = free_blocks [size_class];
+    free_blocks [size_class] = block_;
+    free_counts [size_class]++;
+}
+
+void *zmq::msg_pool_t::allocate (size_t size_)
+{
+    if (unlikely (size_ > (size_t) -1 - sizeof (block_t)))
+        return NULL;
+    size_t size = sizeof (block_t) + size_;
+
+    //  Small blocks are allocated from the pool.
+    if (likely (size <= msg_pool_max_block_size)) {
+        msg_pool_t *pool = current ();
+        if (likely (pool != NULL)) {
+            size_t size_class = 0;
+#if defined __GNUC__
+            if (size > min_block_size)
+                size_class = sizeof (unsigned long) * 8 -
+                    __builtin_clzl ((unsigned long) size - 1) - 6;
+#else
+            while ((size_t) min_block_size << size_class < size)
+                size_class++;
+#endif
+            block_t *block = pool->alloc_block (size_class);
+            return block ? block + 1 : NULL;
+        }
+    }
+
+    block_t *block = (block_t*) malloc (size);
+    if (!block)
+        return NULL;
+    block->owner = NULL;
+    return block + 1;
+}
+
+void zmq::msg_pool_t::deallocate (void *ptr_)
+{
+    block_t *block = ((block_t*) ptr_) - 1;
+
+    //  Large blocks are returned directly to the heap.
+    msg_pool_t *owner = block->owner;
+    if (!owner) {
+        free (block);
+        return;
+    }
+
+    //  Blocks owned by the current thread are simply put to the free list.
+    msg_pool_t *pool = current ();
+    if (likely (owner == pool)) {
+        pool->release (block);
+        return;
+    }
+
+    //  Blocks owned by a different thread are passed back to the owner in
+    //  batches. If this thread has no pool to collect the batch in, the
+    //  block is passed back straight away.
+    if (pool)
+        pool->give_back (block);
+    else
+        owner->push_returned (block, block);
+}
+
+zmq::msg_pool_t *zmq::msg_pool_t::create ()
+{
+#if defined ZMQ_HAVE_WINDOWS
+    return NULL;
+#else
+    int rc = pthread_once (&pool_key_once, create_key);
+    posix_assert (rc);
+
+    //  Adopt a pool left by an exited thread, if there's one.
+    msg_pool_t *pool = NULL;
+    orphans_sync.lock ();
+    if (!orphans.empty ()) {
+        pool = (msg_pool_t*) orphans.back ();
+        orphans.pop_back ();
+    }
+    orphans_sync.unlock ();
+
+    if (!pool) {
+        pool = new (std::nothrow) msg_pool_t;
+        if (!pool)
+            return NULL;
+    }
+
+    rc = pthread_setspecific (pool_key, pool);
+    posix_assert (rc);
+#if defined ZMQ_MSG_POOL_TLS
+    tls_pool = pool;
+#endif
+    return pool;
+#endif
+}
+
+void zmq::msg_pool_t::create_key ()
+{
+#if !defined ZMQ_HAVE_WINDOWS
+    int rc = pthread_key_create (&pool_key, orphan);
+    posix_assert (rc);
+#endif
+}
+
+void zmq::msg_pool_t::orphan (void *pool_)
+{
+#if !defined ZMQ_HAVE_WINDOWS
+    //  Blocks collected for other pools would be stuck in the orphaned pool
+    //  otherwise.
+    msg_pool_t *pool = (msg_pool_t*) pool_;
+    pool->flush_batch ();
+
+#if defined ZMQ_MSG_POOL_TLS
+    tls_pool = NULL;
+#endif
+    orphans_sync.lock ();
+    orphans.push_back (pool);
+    orphans_sync.unlock ();
+#endif
+}
+
+void zmq::msg_pool_t::give_back (block_t *block_)
+{
+    //  The batch holds blocks of a single owner. Typically, all the blocks
+    //  deallocated by a thread come from the same I/O thread.
+    if (block_->owner != batch_owner) {
+        flush_batch ();
+        batch_owner = block_->owner;
+        batch_last = block_;
+    }
+    next (block_) = batch_first;
+    batch_first = block_;
+    if (++batch_count == return_batch_size)
+        flush_batch ();
+}
+
+void zmq::msg_pool_t::flush_batch ()
+{
+    if (batch_first)
+        batch_owner->push_returned (batch_first, batch_last);
+    batch_owner = NULL;
+    batch_first = NULL;
+    batch_last = NULL;
+    batch_count = 0;
+}
+
+void zmq::msg_pool_t::push_returned (block_t *first_, block_t *last_)
+{
+    block_t *head = returned.cas (NULL, NULL);
+    while (true) {
+        next (last_) = head;
+        block_t *prev = returned.cas (head, first_);
+        if (prev == head)
+            break;
+        head = prev;
+    }
+}
+
+zmq::msg_pool_t::block_t *zmq::msg_pool_t::reclaim (size_t size_class_)
+{
+    //  Blocks returned by other threads are sorted out one by one, only
+    //  as long as there's no block of the requested size among them. That
+    //  way each block is touched only once before it's used again. They are
+    //  never deallocated to the heap here as they replace blocks that would
+    //  have to be allocated straight away otherwise.
+    while (true) {
+        if (!reclaimed) {
+            reclaimed = returned.xchg (NULL);
+            if (!reclaimed)
+                break;
+        }
+        block_t *block = reclaimed;
+        reclaimed = next (block);
+        size_t size_class = block->size_class;
+        if (size_class == size_class_)
+            return block;
+        next (block) = free_blocks [size_class];
+        free_blocks [size_class] = block;
+        free_counts [size_class]++;
+    }
+
+    block_t *block = (block_t*) malloc ((size_t) min_block_size << size_class_);
+    if (!block)
+        return NULL;
+    block->owner = this;
+    block->size_class = size_class_;
+    return block;
+}
@@ -0,0 +1,160 @@
+/*
+    Copyright (c) 2007-2010 iMatix Corporation
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the Lesser GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    Lesser GNU General Public License for more details.
+
+    You should have received a copy of the Lesser GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_MSG_POOL_HPP_INCLUDED__
+#define __ZMQ_MSG_POOL_HPP_INCLUDED__
+
+#include <stddef.h>
+
+#include "config.hpp"
+#include "atomic_ptr.hpp"
+
+namespace zmq
+{
+
+    //  Allocator for message buffers. Small buffers are served from
+    //  per-thread pools segregated into power-of-two size classes. Buffers
+    //  allocated and deallocated by the same thread are simply taken from
+    //  and put back to the thread's free lists with no locking nor atomic
+    //  operations.
+    //
+    //  Buffers deallocated by a different thread, typically the messages
+    //  received by an I/O thread and closed by an application thread, are
+    //  collected into batches and passed back to the owning pool with
+    //  single atomic operation per batch. Note that up to one batch of such
+    //  buffers per thread may wait in the batch till the thread deallocates
+    //  more of them or exits.
+    //
+    //  Pools are never destroyed. When a thread exits its pool is orphaned
+    //  and adopted by the next thread that needs a pool, so the buffers in
+    //  flight are never lost. On platforms without thread-specific storage
+    //  destructors (Windows) all the buffers are allocated from the heap.
+
+    class msg_pool_t
+    {
+    public:
+
+        //  Allocates buffer of the specified size. Returns NULL if there's
+        //  not enough memory.
+        static void *allocate (size_t size_);
+
+        //  Deallocates the buffer. Can be called from any thread.
+        static void deallocate (void *ptr_);
+
+    private:
+
+        msg_pool_t ();
+        ~msg_pool_t ();
+
+        //  Header preceding each buffer. While the block is free, the
+        //  space following the header holds the link to the next block.
+        struct block_t
+        {
+            //  Pool the block belongs to. NULL if the block was allocated
+            //  directly from the heap.
+            msg_pool_t *owner;
+
+            //  Index of the size class.
+            size_t size_class;
+        };
+
+        enum
+        {
+            //  Size of the blocks in the smallest class.
+            min_block_size = 64,
+
+            //  Number of size classes.
+            size_classes = 8,
+
+            //  Number of blocks owned by another pool collected before
+            //  they are passed back to the owner.
+            return_batch_size = 64
+        };
+
+        //  Returns reference to the link to the next free block.
+        inline static block_t *&next (block_t *block_);
+
+        //  Returns the pool associated with the calling thread. If there's
+        //  no such pool yet, a new one is associated with the thread. Returns
+        //  NULL if that is not possible.
+        inline static msg_pool_t *current ();
+
+        //  Associates a pool with the calling thread.
+        static msg_pool_t *create ();
+
+        //  Creates the thread-specific storage key used to get notified when
+        //  the thread owning the pool exits.
+        static void create_key ();
+
+        //  Invoked when the thread owning the pool exits.
+        static void orphan (void *pool_);
+
+        //  Allocates block from the specified size class.
+        inline block_t *alloc_block (size_t size_class_);
+
+        //  Puts the block to the free list or returns it to the heap if
+        //  there are too many free blocks of that size already. Called only
+        //  by the thread owning the pool.
+        inline void release (block_t *block_);
+
+        //  Adds a block owned by another pool to the batch of blocks to be
+        //  passed back to their owner.
+        void give_back (block_t *block_);
+
+        //  Passes the batch of blocks back to their owner.
+        void flush_batch ();
+
+        //  Passes the list of blocks to the pool's return queue. The owner
+        //  always takes the whole queue at once, thus there's no ABA problem.
+        void push_returned (block_t *first_, block_t *last_);
+
+        //  Allocates block from the specified size class when the free list
+        //  is empty. Blocks deallocated by other threads are moved to the
+        //  free lists on the way. The cache limit doesn't apply to those,
+        //  thus a pool may keep as many free blocks as it had blocks in
+        //  flight at the peak.
+        block_t *reclaim (size_t size_class_);
+
+        //  Free blocks for individual size classes.
+        block_t *free_blocks [size_classes];
+        int free_counts [size_classes];
+
+        //  Maximal number of free blocks cached for each size class.
+        int free_limits [size_classes];
+
+        //  Blocks returned by other threads.
+        atomic_ptr_t <block_t> returned;
+
+        //  Blocks taken from 'returned' not sorted to the free lists yet.
+        block_t *reclaimed;
+
+        //  Blocks owned by 'batch_owner' deallocated by this thread and
+        //  not yet passed back to the owner.
+        msg_pool_t *batch_owner;
+        block_t *batch_first;
+        block_t *batch_last;
+        int batch_count;
+
+        msg_pool_t (const msg_pool_t&);
+        void operator = (const msg_pool_t&);
+    };
+
+}
+
+#endif
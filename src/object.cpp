@@ -96,7 +96,8 @@ void zmq::object_t::process_command (command_t &cmd_)
         break;
 
     case command_t::reader_info:
-        process_reader_info (cmd_.args.reader_info.msgs_read);
+        process_reader_info (cmd_.args.reader_info.msgs_read,
+            cmd_.args.reader_info.bytes_read);
         break;
 
     case command_t::pipe_term:
@@ -160,13 +161,12 @@ zmq::io_thread_t *zmq::object_t::choose_io_thread (uint64_t taskset_)
 
 void zmq::object_t::send_stop ()
 {
-    //  'stop' command goes always from administrative thread to
+    //  'stop' command goes always from the thread terminating 0MQ to
     //  the current object. 
-    int admin_thread_id = dispatcher->thread_slot_count () - 1;
     command_t cmd;
     cmd.destination = this;
     cmd.type = command_t::stop;
-    dispatcher->write (admin_thread_id, thread_slot, cmd);
+    dispatcher->write (thread_slot, cmd);
 }
 
 void zmq::object_t::send_plug (owned_t *destination_, bool inc_seqnum_)
@@ -254,12 +254,13 @@ void zmq::object_t::send_revive (object_t *destination_)
 }
 
 void zmq::object_t::send_reader_info (writer_t *destination_,
-    uint64_t msgs_read_)
+    uint64_t msgs_read_, uint64_t bytes_read_)
 {
     command_t cmd;
     cmd.destination = destination_;
     cmd.type = command_t::reader_info;
     cmd.args.reader_info.msgs_read = msgs_read_;
+    cmd.args.reader_info.bytes_read = bytes_read_;
     send_command (cmd);
 }
 
@@ -337,7 +338,8 @@ void zmq::object_t::process_revive ()
     zmq_assert (false);
 }
 
-void zmq::object_t::process_reader_info (uint64_t msgs_read_)
+void zmq::object_t::process_reader_info (uint64_t msgs_read_,
+    uint64_t bytes_read_)
 {
     zmq_assert (false);
 }
@@ -375,6 +377,6 @@ void zmq::object_t::process_seqnum ()
 void zmq::object_t::send_command (command_t &cmd_)
 {
     int destination_thread_slot = cmd_.destination->get_thread_slot ();
-    dispatcher->write (thread_slot, destination_thread_slot, cmd_);
+    dispatcher->write (destination_thread_slot, cmd_);
 }
 
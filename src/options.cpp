@@ -17,14 +17,33 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <string.h>
+
 #include "../include/zmq.h"
 
 #include "options.hpp"
+#include "config.hpp"
 #include "err.hpp"
 
+//  Copies the option value to the user-supplied buffer and sets its length
+//  to the actual size of the value.
+static int get_value (void *optval_, size_t *optvallen_, const void *value_,
+    size_t size_)
+{
+    if (*optvallen_ < size_) {
+        errno = EINVAL;
+        return -1;
+    }
+    memcpy (optval_, value_, size_);
+    *optvallen_ = size_;
+    return 0;
+}
+
 zmq::options_t::options_t () :
     hwm (0),
     lwm (0),
+    hwm_bytes (0),
+    lwm_bytes (0),
     swap (0),
     affinity (0),
     rate (100),
@@ -32,8 +51,16 @@ zmq::options_t::options_t () :
     use_multicast_loop (true),
     sndbuf (0),
     rcvbuf (0),
+    rcvspin (0),
+    in_batch_size (zmq::in_batch_size),
+    out_batch_size (zmq::out_batch_size),
+    inbound_poll_rate (zmq::inbound_poll_rate),
+    max_command_delay (zmq::max_command_delay),
+    backlog (tcp_connection_backlog),
     requires_in (false),
     requires_out (false),
+    requires_subscriptions (false),
+    forward_subscriptions (true),
     immediate_connect (true)
 {
 }
@@ -59,6 +86,22 @@ int zmq::options_t::setsockopt (int option_, const void *optval_,
         lwm = *((uint64_t*) optval_);
         return 0;
 
+    case ZMQ_HWM_BYTES:
+        if (optvallen_ != sizeof (uint64_t)) {
+            errno = EINVAL;
+            return -1;
+        }
+        hwm_bytes = *((uint64_t*) optval_);
+        return 0;
+
+    case ZMQ_LWM_BYTES:
+        if (optvallen_ != sizeof (uint64_t)) {
+            errno = EINVAL;
+            return -1;
+        }
+        lwm_bytes = *((uint64_t*) optval_);
+        return 0;
+
     case ZMQ_SWAP:
         if (optvallen_ != sizeof (int64_t)) {
             errno = EINVAL;
@@ -134,6 +177,131 @@ int zmq::options_t::setsockopt (int option_, const void *optval_,
         }
         rcvbuf = *((uint64_t*) optval_);
         return 0;
+
+    case ZMQ_RCVSPIN:
+        if (optvallen_ != sizeof (uint64_t)) {
+            errno = EINVAL;
+            return -1;
+        }
+        rcvspin = *((uint64_t*) optval_);
+        return 0;
+
+    case ZMQ_IN_BATCH_SIZE:
+        if (optvallen_ != sizeof (uint64_t) || !*((uint64_t*) optval_)) {
+            errno = EINVAL;
+            return -1;
+        }
+        in_batch_size = *((uint64_t*) optval_);
+        return 0;
+
+    case ZMQ_OUT_BATCH_SIZE:
+        if (optvallen_ != sizeof (uint64_t) || !*((uint64_t*) optval_)) {
+            errno = EINVAL;
+            return -1;
+        }
+        out_batch_size = *((uint64_t*) optval_);
+        return 0;
+
+    case ZMQ_INBOUND_POLL_RATE:
+        if (optvallen_ != sizeof (uint64_t) || !*((uint64_t*) optval_)) {
+            errno = EINVAL;
+            return -1;
+        }
+        inbound_poll_rate = *((uint64_t*) optval_);
+        return 0;
+
+    case ZMQ_COMMAND_DELAY:
+        if (optvallen_ != sizeof (uint64_t)) {
+            errno = EINVAL;
+            return -1;
+        }
+        max_command_delay = *((uint64_t*) optval_);
+        return 0;
+
+    case ZMQ_BACKLOG:
+        if (optvallen_ != sizeof (int64_t) || *((int64_t*) optval_) < 0 ||
+              *((int64_t*) optval_) > 0x7fffffff) {
+            errno = EINVAL;
+            return -1;
+        }
+        backlog = (int) *((int64_t*) optval_);
+        return 0;
+    }
+
+    errno = EINVAL;
+    return -1;
+}
+
+int zmq::options_t::getsockopt (int option_, void *optval_,
+    size_t *optvallen_)
+{
+    //  Options are returned in the same format they are set in.
+    int64_t value;
+    switch (option_) {
+
+    case ZMQ_HWM:
+        return get_value (optval_, optvallen_, &hwm, sizeof (uint64_t));
+
+    case ZMQ_LWM:
+        return get_value (optval_, optvallen_, &lwm, sizeof (uint64_t));
+
+    case ZMQ_HWM_BYTES:
+        return get_value (optval_, optvallen_, &hwm_bytes, sizeof (uint64_t));
+
+    case ZMQ_LWM_BYTES:
+        return get_value (optval_, optvallen_, &lwm_bytes, sizeof (uint64_t));
+
+    case ZMQ_SWAP:
+        return get_value (optval_, optvallen_, &swap, sizeof (int64_t));
+
+    case ZMQ_AFFINITY:
+        value = (int64_t) affinity;
+        return get_value (optval_, optvallen_, &value, sizeof (int64_t));
+
+    case ZMQ_IDENTITY:
+        return get_value (optval_, optvallen_, identity.data (),
+            identity.size ());
+
+    case ZMQ_RATE:
+        value = rate;
+        return get_value (optval_, optvallen_, &value, sizeof (int64_t));
+
+    case ZMQ_RECOVERY_IVL:
+        value = recovery_ivl;
+        return get_value (optval_, optvallen_, &value, sizeof (int64_t));
+
+    case ZMQ_MCAST_LOOP:
+        value = use_multicast_loop ? 1 : 0;
+        return get_value (optval_, optvallen_, &value, sizeof (int64_t));
+
+    case ZMQ_SNDBUF:
+        return get_value (optval_, optvallen_, &sndbuf, sizeof (uint64_t));
+
+    case ZMQ_RCVBUF:
+        return get_value (optval_, optvallen_, &rcvbuf, sizeof (uint64_t));
+
+    case ZMQ_RCVSPIN:
+        return get_value (optval_, optvallen_, &rcvspin, sizeof (uint64_t));
+
+    case ZMQ_IN_BATCH_SIZE:
+        return get_value (optval_, optvallen_, &in_batch_size,
+            sizeof (uint64_t));
+
+    case ZMQ_OUT_BATCH_SIZE:
+        return get_value (optval_, optvallen_, &out_batch_size,
+            sizeof (uint64_t));
+
+    case ZMQ_INBOUND_POLL_RATE:
+        return get_value (optval_, optvallen_, &inbound_poll_rate,
+            sizeof (uint64_t));
+
+    case ZMQ_COMMAND_DELAY:
+        return get_value (optval_, optvallen_, &max_command_delay,
+            sizeof (uint64_t));
+
+    case ZMQ_BACKLOG:
+        value = backlog;
+        return get_value (optval_, optvallen_, &value, sizeof (int64_t));
     }
 
     errno = EINVAL;
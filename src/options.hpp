@@ -32,9 +32,15 @@ namespace zmq
         options_t ();
 
         int setsockopt (int option_, const void *optval_, size_t optvallen_);
+        int getsockopt (int option_, void *optval_, size_t *optvallen_);
 
         uint64_t hwm;
         uint64_t lwm;
+
+        //  High and low watermarks in bytes. Zero means no limit.
+        uint64_t hwm_bytes;
+        uint64_t lwm_bytes;
+
         int64_t swap;
         uint64_t affinity;
         blob_t identity;
@@ -51,11 +57,33 @@ namespace zmq
         uint64_t sndbuf;
         uint64_t rcvbuf;
 
+        //  Time to busy-poll for a message in blocking recv before going
+        //  to sleep [us]. Default 0, i.e. go to sleep straight away.
+        uint64_t rcvspin;
+
+        //  Tuning of the engines and of command processing. Defaults are
+        //  taken from config.hpp; see there for the meaning of the values.
+        uint64_t in_batch_size;
+        uint64_t out_batch_size;
+        uint64_t inbound_poll_rate;
+        uint64_t max_command_delay;
+        int backlog;
+
         //  These options are never set by the user directly. Instead they are
         //  provided by the specific socket type.
         bool requires_in;
         bool requires_out;
 
+        //  If true, the socket exchanges subscriptions with its peers in
+        //  the direction opposite to the messages flow (PUB and SUB sockets).
+        //  A pipe for the subscriptions is created in that direction.
+        bool requires_subscriptions;
+
+        //  If false, the transport is uni-directional and the subscriptions
+        //  can't be forwarded to the peer (PGM). They are still used to
+        //  filter the messages on the subscriber side.
+        bool forward_subscriptions;
+
         //  If true, when connecting, pipes are created immediately without
         //  waiting for the connection to be established. That way the socket
         //  is not aware of the peer's identity, however, it is able to send
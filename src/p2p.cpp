@@ -100,7 +100,8 @@ int zmq::p2p_t::xsend (zmq_msg_t *msg_, int flags_)
         return -1;
     }
 
-    outpipe->flush ();
+    if (!(flags_ & send_noflush))
+        outpipe->flush ();
 
     //  Detach the original message from the data buffer.
     int rc = zmq_msg_init (msg_);
@@ -121,6 +122,12 @@ int zmq::p2p_t::xrecv (zmq_msg_t *msg_, int flags_)
     return 0;
 }
 
+void zmq::p2p_t::xflush ()
+{
+    if (outpipe)
+        outpipe->flush ();
+}
+
 bool zmq::p2p_t::xhas_in ()
 {
     if (alive && inpipe && inpipe->check_read ())
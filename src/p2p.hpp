@@ -43,6 +43,7 @@ namespace zmq
         int xsetsockopt (int option_, const void *optval_, size_t optvallen_);
         int xsend (zmq_msg_t *msg_, int flags_);
         int xrecv (zmq_msg_t *msg_, int flags_);
+        void xflush ();
         bool xhas_in ();
         bool xhas_out ();
 
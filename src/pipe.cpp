@@ -17,23 +17,34 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <new>
+
 #include "../include/zmq.h"
 
 #include "pipe.hpp"
+#include "swap.hpp"
+#include "likely.hpp"
 
-zmq::reader_t::reader_t (object_t *parent_,
-      uint64_t hwm_, uint64_t lwm_) :
+zmq::reader_t::reader_t (object_t *parent_, uint64_t hwm_, uint64_t lwm_,
+      uint64_t hwm_bytes_, uint64_t lwm_bytes_) :
     object_t (parent_),
     pipe (NULL),
     peer (NULL),
     hwm (hwm_),
     lwm (lwm_),
+    hwm_bytes (hwm_bytes_),
+    lwm_bytes (lwm_bytes_),
     msgs_read (0),
+    bytes_read (0),
+    partial_bytes (0),
+    bytes_reported (0),
     endpoint (NULL)
 {
     //  Adjust lwm and hwm.
     if (lwm == 0 || lwm > hwm)
         lwm = hwm;
+    if (lwm_bytes == 0 || lwm_bytes > hwm_bytes)
+        lwm_bytes = hwm_bytes;
 }
 
 zmq::reader_t::~reader_t ()
@@ -77,11 +88,21 @@ bool zmq::reader_t::read (zmq_msg_t *msg_)
         return false;
     }
 
-    if (!(msg_->flags & ZMQ_MSG_MORE))
-        msgs_read++;
+    partial_bytes += zmq_msg_size (msg_);
+    if (msg_->flags & ZMQ_MSG_MORE)
+        return true;
+
+    msgs_read++;
+    bytes_read += partial_bytes;
+    partial_bytes = 0;
 
-    if (lwm > 0 && msgs_read % lwm == 0)
-        send_reader_info (peer, msgs_read);
+    //  Let the writer know about the progress each lwm messages or each
+    //  lwm_bytes bytes read, whichever comes first.
+    if ((lwm > 0 && msgs_read % lwm == 0) ||
+          (lwm_bytes > 0 && bytes_read - bytes_reported >= lwm_bytes)) {
+        send_reader_info (peer, msgs_read, bytes_read);
+        bytes_reported = bytes_read;
+    }
 
     return true;
 }
@@ -112,21 +133,45 @@ void zmq::reader_t::process_pipe_term_ack ()
     delete pipe;
 }
 
-zmq::writer_t::writer_t (object_t *parent_,
-      uint64_t hwm_, uint64_t lwm_) :
+zmq::writer_t::writer_t (object_t *parent_, uint64_t hwm_, uint64_t lwm_,
+      uint64_t hwm_bytes_, uint64_t lwm_bytes_, int64_t swap_size_) :
     object_t (parent_),
     pipe (NULL),
     peer (NULL),
     hwm (hwm_),
     lwm (lwm_),
+    hwm_bytes (hwm_bytes_),
+    lwm_bytes (lwm_bytes_),
     msgs_read (0),
     msgs_written (0),
+    msgs_flushed (0),
+    bytes_flushed (0),
+    bytes_read (0),
+    bytes_written (0),
+    partial_bytes (0),
     stalled (false),
+    swap (NULL),
+    swapping (false),
+    pending_delimiter (false),
     endpoint (NULL)
 {
     //  Adjust lwm and hwm.
     if (lwm == 0 || lwm > hwm)
         lwm = hwm;
+    if (lwm_bytes == 0 || lwm_bytes > hwm_bytes)
+        lwm_bytes = hwm_bytes;
+
+    //  Swap makes sense only if there's a high watermark to exceed. If
+    //  the swap file can't be created, the pipe works without it, i.e.
+    //  the high watermark applies as if no swap was requested.
+    if ((hwm > 0 || hwm_bytes > 0) && swap_size_ > 0) {
+        swap = new (std::nothrow) swap_t (swap_size_);
+        zmq_assert (swap);
+        if (swap->init () != 0) {
+            delete swap;
+            swap = NULL;
+        }
+    }
 }
 
 void zmq::writer_t::set_endpoint (i_endpoint *endpoint_)
@@ -136,6 +181,8 @@ void zmq::writer_t::set_endpoint (i_endpoint *endpoint_)
 
 zmq::writer_t::~writer_t ()
 {
+    if (swap)
+        delete swap;
 }
 
 void zmq::writer_t::set_pipe (pipe_t *pipe_)
@@ -147,7 +194,7 @@ void zmq::writer_t::set_pipe (pipe_t *pipe_)
 
 bool zmq::writer_t::check_write ()
 {
-    if (pipe_full ()) {
+    if (!can_write (0)) {
         stalled = true;
         return false;
     }
@@ -157,19 +204,40 @@ bool zmq::writer_t::check_write ()
 
 bool zmq::writer_t::write (zmq_msg_t *msg_)
 {
-    if (pipe_full ()) {
+    if (!can_write (zmq_msg_size (msg_))) {
         stalled = true;
         return false;
     }
 
+    //  In swapping mode the message is copied to the swap. The message is
+    //  considered to be consumed by the pipe, so it is deallocated here.
+    if (unlikely (swapping)) {
+        swap->store (msg_);
+        if (!(msg_->flags & ZMQ_MSG_MORE))
+            swap->commit ();
+        int rc = zmq_msg_close (msg_);
+        zmq_assert (rc == 0);
+        return true;
+    }
+
+    partial_bytes += zmq_msg_size (msg_);
     pipe->write (*msg_);
-    if (!(msg_->flags & ZMQ_MSG_MORE))
+    if (!(msg_->flags & ZMQ_MSG_MORE)) {
         msgs_written++;
+        bytes_written += partial_bytes;
+        partial_bytes = 0;
+    }
     return true;
 }
 
 void zmq::writer_t::rollback ()
 {
+    //  Remove incomplete message from the swap.
+    if (swap)
+        swap->rollback ();
+
+    partial_bytes = 0;
+
     zmq_msg_t msg;
 
     while (pipe->unwrite (&msg)) {
@@ -189,8 +257,70 @@ void zmq::writer_t::rollback ()
 
 void zmq::writer_t::flush ()
 {
-    if (!pipe->flush ())
+    //  Note that even in swapping mode there may be messages written to
+    //  the pipe before the swapping started. Those have to be flushed as
+    //  well, otherwise the reader would never get to them.
+    //
+    //  If the reader went asleep, it won't report its progress any more, so
+    //  the messages from the swap have to be moved to the pipe straight away.
+    if (!flush_pipe () && swapping)
+        swap_in ();
+}
+
+bool zmq::writer_t::flush_pipe ()
+{
+    //  If the reader went asleep, it has read all the messages flushed
+    //  before. There's no need to wait for it to report the progress.
+    bool awake = pipe->flush ();
+    if (!awake) {
+        if (msgs_read < msgs_flushed)
+            msgs_read = msgs_flushed;
+        if (bytes_read < bytes_flushed)
+            bytes_read = bytes_flushed;
         send_revive (peer);
+    }
+    msgs_flushed = msgs_written;
+    bytes_flushed = bytes_written;
+    return awake;
+}
+
+void zmq::writer_t::swap_in ()
+{
+    //  Only complete messages are moved. If the reader has read all
+    //  the messages in the pipe by the time they are flushed, there's room
+    //  for more of them straight away.
+    while (true) {
+        bool moved = false;
+        uint64_t size = 0;
+        while (!pipe_full () && swap->check_fetch ()) {
+            zmq_msg_t msg;
+            swap->fetch (&msg);
+            size += zmq_msg_size (&msg);
+            pipe->write (msg);
+            if (!(msg.flags & ZMQ_MSG_MORE)) {
+                msgs_written++;
+                bytes_written += size;
+                size = 0;
+            }
+            moved = true;
+        }
+        if (!moved || flush_pipe ())
+            break;
+    }
+
+    //  If the swap was drained, switch back to in-memory mode.
+    if (swap->empty ()) {
+        swapping = false;
+        if (pending_delimiter) {
+            pending_delimiter = false;
+            write_delimiter ();
+        }
+    }
+}
+
+uint64_t zmq::writer_t::queue_size ()
+{
+    return msgs_written - msgs_read;
 }
 
 void zmq::writer_t::term ()
@@ -200,6 +330,21 @@ void zmq::writer_t::term ()
     //  Rollback any unfinished messages.
     rollback ();
 
+    //  If there are messages in the swap, delimiter has to wait till they
+    //  are passed to the reader.
+    if (swapping) {
+        if (!swap->empty ()) {
+            pending_delimiter = true;
+            return;
+        }
+        swapping = false;
+    }
+
+    write_delimiter ();
+}
+
+void zmq::writer_t::write_delimiter ()
+{
     //  Push delimiter into the pipe.
     //  Trick the compiler to belive that the tag is a valid pointer.
     zmq_msg_t msg;
@@ -210,9 +355,20 @@ void zmq::writer_t::term ()
     pipe->flush ();
 }
 
-void zmq::writer_t::process_reader_info (uint64_t msgs_read_)
+void zmq::writer_t::process_reader_info (uint64_t msgs_read_,
+    uint64_t bytes_read_)
 {
-    msgs_read = msgs_read_;
+    //  The progress may have been already accounted for when the reader
+    //  drained the pipe.
+    if (msgs_read < msgs_read_)
+        msgs_read = msgs_read_;
+    if (bytes_read < bytes_read_)
+        bytes_read = bytes_read_;
+
+    //  Reader is catching up. Move the messages from the swap to the pipe.
+    if (swapping)
+        swap_in ();
+
     if (stalled && endpoint != NULL) {
         stalled = false;
         endpoint->revive (this);
@@ -231,13 +387,37 @@ void zmq::writer_t::process_pipe_term ()
 
 bool zmq::writer_t::pipe_full ()
 {
-    return hwm > 0 && msgs_written - msgs_read == hwm;
+    if (hwm > 0 && msgs_written - msgs_read == hwm)
+        return true;
+
+    //  Unlike the message count, the byte count may overshoot the limit as
+    //  the last message written may be larger than the space left.
+    return hwm_bytes > 0 && bytes_written - bytes_read >= hwm_bytes;
+}
+
+bool zmq::writer_t::can_write (size_t size_)
+{
+    //  Once swapping has started, all the messages have to go to the swap
+    //  so that the ordering is preserved.
+    if (unlikely (swapping))
+        return swap->fits (size_);
+
+    if (!pipe_full ())
+        return true;
+
+    if (swap && swap->fits (size_)) {
+        swapping = true;
+        return true;
+    }
+
+    return false;
 }
 
 zmq::pipe_t::pipe_t (object_t *reader_parent_, object_t *writer_parent_,
-      uint64_t hwm_, uint64_t lwm_) :
-    reader (reader_parent_, hwm_, lwm_),
-    writer (writer_parent_, hwm_, lwm_)
+      uint64_t hwm_, uint64_t lwm_, uint64_t hwm_bytes_,
+      uint64_t lwm_bytes_, int64_t swap_size_) :
+    reader (reader_parent_, hwm_, lwm_, hwm_bytes_, lwm_bytes_),
+    writer (writer_parent_, hwm_, lwm_, hwm_bytes_, lwm_bytes_, swap_size_)
 {
     reader.set_pipe (this);
     writer.set_pipe (this);
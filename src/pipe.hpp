@@ -36,8 +36,8 @@ namespace zmq
     {
     public:
 
-        reader_t (class object_t *parent_,
-            uint64_t hwm_, uint64_t lwm_);
+        reader_t (class object_t *parent_, uint64_t hwm_, uint64_t lwm_,
+            uint64_t hwm_bytes_, uint64_t lwm_bytes_);
         ~reader_t ();
 
         void set_pipe (class pipe_t *pipe_);
@@ -64,13 +64,26 @@ namespace zmq
         //  Pipe writer associated with the other side of the pipe.
         class writer_t *peer;
 
-        //  High and low watermarks for in-memory storage (in bytes).
+        //  High and low watermarks for in-memory storage (in messages).
         uint64_t hwm;
         uint64_t lwm;
 
+        //  High and low watermarks for in-memory storage (in bytes).
+        uint64_t hwm_bytes;
+        uint64_t lwm_bytes;
+
         //  Number of messages read so far.
         uint64_t msgs_read;
 
+        //  Number of bytes read so far. Only complete messages are counted.
+        uint64_t bytes_read;
+
+        //  Size of the parts of the current message read so far.
+        uint64_t partial_bytes;
+
+        //  Number of bytes read at the time the writer was last notified.
+        uint64_t bytes_reported;
+
         //  Endpoint (either session or socket) the pipe is attached to.
         i_endpoint *endpoint;
 
@@ -82,8 +95,8 @@ namespace zmq
     {
     public:
 
-        writer_t (class object_t *parent_,
-            uint64_t hwm_, uint64_t lwm_);
+        writer_t (class object_t *parent_, uint64_t hwm_, uint64_t lwm_,
+            uint64_t hwm_bytes_, uint64_t lwm_bytes_, int64_t swap_size_);
         ~writer_t ();
 
         void set_pipe (class pipe_t *pipe_);
@@ -91,7 +104,8 @@ namespace zmq
 
         //  Checks whether a message can be written to the pipe.
         //  If writing the message would cause high watermark to be
-        //  exceeded, the function returns false.
+        //  exceeded and there's no space left in the swap, the function
+        //  returns false.
         bool check_write ();
 
         //  Writes a message to the underlying pipe. Returns false if the
@@ -101,6 +115,11 @@ namespace zmq
         //  Remove unfinished part of a message from the pipe.
         void rollback ();
 
+        //  Returns the number of messages written to the pipe that the reader
+        //  is not yet known to have read. The number is exact when the reader
+        //  has drained the pipe, otherwise it is updated each lwm messages.
+        uint64_t queue_size ();
+
         //  Flush the messages downsteam.
         void flush ();
 
@@ -109,7 +128,7 @@ namespace zmq
 
     private:
 
-        void process_reader_info (uint64_t msgs_read_);
+        void process_reader_info (uint64_t msgs_read_, uint64_t bytes_read_);
 
         //  Command handlers.
         void process_pipe_term ();
@@ -117,16 +136,38 @@ namespace zmq
         //  Tests whether the pipe is already full.
         bool pipe_full ();
 
+        //  Tests whether a message of the specified size can be written
+        //  either to the pipe or to the swap. Switches to swapping mode
+        //  if the pipe is full.
+        bool can_write (size_t size_);
+
+        //  Writes the delimiter to the pipe.
+        void write_delimiter ();
+
+        //  Flushes the messages written to the pipe. Returns false if
+        //  the reader had already read all the messages flushed before
+        //  and went asleep.
+        bool flush_pipe ();
+
+        //  Moves as many messages from the swap to the pipe as the high
+        //  watermark allows. Switches back to in-memory mode once the swap
+        //  is drained.
+        void swap_in ();
+
         //  The underlying pipe.
         class pipe_t *pipe;
 
         //  Pipe reader associated with the other side of the pipe.
         class reader_t *peer;
 
-        //  High and low watermarks for in-memory storage (in bytes).
+        //  High and low watermarks for in-memory storage (in messages).
         uint64_t hwm;
         uint64_t lwm;
 
+        //  High and low watermarks for in-memory storage (in bytes).
+        uint64_t hwm_bytes;
+        uint64_t lwm_bytes;
+
         //  Last confirmed number of messages read from the pipe.
         //  The actual number can be higher.
         uint64_t msgs_read;
@@ -134,9 +175,37 @@ namespace zmq
         //  Number of messages we have written so far.
         uint64_t msgs_written;
 
+        //  Number of messages and bytes written at the time of the last flush.
+        uint64_t msgs_flushed;
+        uint64_t bytes_flushed;
+
+        //  Last confirmed number of bytes read from the pipe.
+        uint64_t bytes_read;
+
+        //  Number of bytes we have written so far. Only complete messages
+        //  are counted so that the limit is never hit in the middle of
+        //  a multi-part message.
+        uint64_t bytes_written;
+
+        //  Size of the parts of the current message written so far.
+        uint64_t partial_bytes;
+
         //  True iff the last attempt to write a message has failed.
         bool stalled;
 
+        //  Swap file to store messages exceeding the high watermark. NULL
+        //  if swapping is not enabled for the pipe.
+        class swap_t *swap;
+
+        //  If true, messages are written to the swap rather than to the
+        //  pipe. The mode is switched off once the swap is drained.
+        bool swapping;
+
+        //  If true, pipe termination was requested while there were still
+        //  messages in the swap. Delimiter has to be written to the pipe
+        //  only after all the swapped messages.
+        bool pending_delimiter;
+
         //  Endpoint (either session or socket) the pipe is attached to.
         i_endpoint *endpoint;
 
@@ -150,7 +219,8 @@ namespace zmq
     public:
 
         pipe_t (object_t *reader_parent_, object_t *writer_parent_,
-            uint64_t hwm_, uint64_t lwm_);
+            uint64_t hwm_, uint64_t lwm_, uint64_t hwm_bytes_,
+            uint64_t lwm_bytes_, int64_t swap_size_);
         ~pipe_t ();
 
         reader_t reader;
@@ -112,16 +112,15 @@ void zmq::poll_t::reset_pollout (handle_t handle_)
     pollset [index].events &= ~((short) POLLOUT);
 }
 
-void zmq::poll_t::add_timer (i_poll_events *events_)
+zmq::timer_wheel_t::handle_t zmq::poll_t::add_timer (int timeout_,
+    i_poll_events *events_, int id_)
 {
-     timers.push_back (events_);
+    return timers.add (timeout_, events_, id_);
 }
 
-void zmq::poll_t::cancel_timer (i_poll_events *events_)
+void zmq::poll_t::cancel_timer (timer_wheel_t::handle_t handle_)
 {
-    timers_t::iterator it = std::find (timers.begin (), timers.end (), events_);
-    if (it != timers.end ())
-        timers.erase (it);
+    timers.cancel (handle_);
 }
 
 int zmq::poll_t::get_load ()
@@ -143,28 +142,15 @@ void zmq::poll_t::loop ()
 {
     while (!stopping) {
 
+        //  Execute any due timers.
+        int timeout = timers.execute ();
+
         //  Wait for events.
-        int rc = poll (&pollset [0], pollset.size (),
-            timers.empty () ? -1 : max_timer_period);
+        int rc = poll (&pollset [0], pollset.size (), timeout);
         if (rc == -1 && errno == EINTR)
             continue;
         errno_assert (rc != -1);
 
-        //  Handle timer.
-        if (!rc) {
-
-            //  Use local list of timers as timer handlers may fill new timers
-            //  into the original array.
-            timers_t t;
-            std::swap (timers, t);
-
-            //  Trigger all the timers.
-            for (timers_t::iterator it = t.begin (); it != t.end (); it ++)
-                (*it)->timer_event ();
-
-            continue;
-        }
-
         for (pollset_t::iterator it = pollset.begin ();
                 it != pollset.end (); it ++) {
 
@@ -17,134 +17,124 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
-#include <stdlib.h>
-
-#include <new>
-#include <algorithm>
+#include <string.h>
 
 #include "err.hpp"
 #include "prefix_tree.hpp"
 
 zmq::prefix_tree_t::prefix_tree_t () :
-    refcnt (0),
-    min (0),
-    count (0)
+    garbage (0)
 {
+    //  Create the root node. It has an empty label.
+    alloc_node ();
 }
 
 zmq::prefix_tree_t::~prefix_tree_t ()
 {
-    if (count == 1)
-        delete next.node;
-    else if (count > 1) {
-        for (unsigned char i = 0; i != count; ++i)
-            if (next.table [i])
-                delete next.table [i];
-        free (next.table);
-    }
 }
 
 void zmq::prefix_tree_t::add (unsigned char *prefix_, size_t size_)
 {
-    //  We are at the node corresponding to the prefix. We are done.
-    if (!size_) {
-        ++refcnt;
-        return;
-    }
-
-    unsigned char c = *prefix_;
-    if (c < min || c >= min + count) {
+    uint32_t current = 0;
+    while (true) {
 
-        //  The character is out of range of currently handled
-        //  charcters. We have to extend the table.
-        if (!count) {
-            min = c;
-            count = 1;
-            next.node = NULL;
+        //  We are at the node corresponding to the prefix. We are done.
+        if (!size_) {
+            ++nodes [current].refcnt;
+            return;
         }
-        else if (count == 1) {
-            unsigned char oldc = min;
-            prefix_tree_t *oldp = next.node;
-            count = (min < c ? c - min : min - c) + 1;
-            next.table = (prefix_tree_t**)
-                malloc (sizeof (prefix_tree_t*) * count);
-            zmq_assert (next.table);
-            for (unsigned char i = 0; i != count; ++i)
-                next.table [i] = 0;
-            min = std::min (min, c);
-            next.table [oldc - min] = oldp;
-        }
-        else if (min < c) {
-
-            //  The new character is above the current character range.
-            unsigned char old_count = count;
-            count = c - min + 1;
-            next.table = (prefix_tree_t**) realloc ((void*) next.table,
-                sizeof (prefix_tree_t*) * count);
-            zmq_assert (next.table);
-            for (unsigned char i = old_count; i != count; i++)
-                next.table [i] = NULL;
-        }
-        else {
-
-            //  The new character is below the current character range.
-            unsigned char old_count = count;
-            count = (min + old_count) - c;
-            next.table = (prefix_tree_t**) realloc ((void*) next.table,
-                sizeof (prefix_tree_t*) * count);
-            zmq_assert (next.table);
-            memmove (next.table + min - c, next.table,
-                old_count * sizeof (prefix_tree_t*));
-            for (unsigned char i = 0; i != min - c; i++)
-                next.table [i] = NULL;
-            min = c;
-        }
-    }
 
-    //  If next node does not exist, create one.
-    if (count == 1) {
-        if (!next.node) {
-            next.node = new (std::nothrow) prefix_tree_t;
-            zmq_assert (next.node);
+        //  If there's no child starting with the next character, create
+        //  a leaf holding the rest of the prefix.
+        int pos = find_child (nodes [current], *prefix_);
+        if (pos < 0) {
+            uint32_t leaf = alloc_node ();
+            nodes [leaf].refcnt = 1;
+            nodes [leaf].label = alloc_label (prefix_, size_);
+            nodes [leaf].label_size = (uint32_t) size_;
+            add_child (current, leaf);
+            return;
         }
-        next.node->add (prefix_ + 1, size_ - 1);
-    }
-    else {
-        if (!next.table [c - min]) {
-            next.table [c - min] = new (std::nothrow) prefix_tree_t;
-            zmq_assert (next.table [c - min]);
+
+        //  Find out how much of the child's label matches the prefix.
+        uint32_t child = children [pos];
+        const unsigned char *label = &labels [nodes [child].label];
+        uint32_t label_size = nodes [child].label_size;
+        uint32_t matched = 1;
+        while (matched != label_size && matched != size_ &&
+              label [matched] == prefix_ [matched])
+            matched++;
+
+        //  If the prefix diverges from the label or ends in the middle of it,
+        //  split the child. The new node takes the matching part of the label
+        //  and the original child becomes its only child.
+        if (matched != label_size) {
+            uint32_t split = alloc_node ();
+            nodes [split].label = nodes [child].label;
+            nodes [split].label_size = matched;
+            nodes [child].label += matched;
+            nodes [child].label_size -= matched;
+            children [pos] = split;
+            add_child (split, child);
+            child = split;
         }
-        next.table [c - min]->add (prefix_ + 1, size_ - 1);
+
+        current = child;
+        prefix_ += matched;
+        size_ -= matched;
     }
 }
 
 bool zmq::prefix_tree_t::rm (unsigned char *prefix_, size_t size_)
 {
-     if (!size_) {
-         if (!refcnt)
-             return false;
-         refcnt--;
-         return true;
-     }
+    //  Find the node corresponding to the prefix.
+    uint32_t parent = 0;
+    uint32_t current = 0;
+    while (size_) {
+        int pos = find_child (nodes [current], *prefix_);
+        if (pos < 0)
+            return false;
+        uint32_t child = children [pos];
+        uint32_t label_size = nodes [child].label_size;
+        if (label_size > size_ ||
+              memcmp (&labels [nodes [child].label], prefix_, label_size) != 0)
+            return false;
+        prefix_ += label_size;
+        size_ -= label_size;
+        parent = current;
+        current = child;
+    }
 
-     unsigned char c = *prefix_;
-     if (!count || c < min || c >= min + count)
-         return false;
+    if (!nodes [current].refcnt)
+        return false;
+    nodes [current].refcnt--;
+    if (nodes [current].refcnt || current == 0)
+        return true;
 
-     prefix_tree_t *next_node =
-         count == 1 ? next.node : next.table [c - min];
+    //  The node is not needed any more. Either remove it, or, if it has
+    //  a single child, merge it with the child.
+    if (!nodes [current].child_count) {
+        rm_child (parent, labels [nodes [current].label]);
+        free_node (current);
+        if (parent != 0 && !nodes [parent].refcnt &&
+              nodes [parent].child_count == 1)
+            merge (parent);
+    }
+    else if (nodes [current].child_count == 1)
+        merge (current);
 
-     if (!next_node)
-         return false;
+    //  Once more than a half of the storage is unused, compact it.
+    if (garbage > labels.size () + children.size () * 5 - garbage)
+        compact ();
 
-     return next_node->rm (prefix_ + 1, size_ - 1);
+    return true;
 }
 
 bool zmq::prefix_tree_t::check (unsigned char *data_, size_t size_)
 {
     //  This function is on critical path. It deliberately doesn't use
     //  recursion to get a bit better performance.
-    prefix_tree_t *current = this;
+    const node_t *current = &nodes [0];
     while (true) {
 
         //  We've found a corresponding subscription!
@@ -155,21 +145,215 @@ bool zmq::prefix_tree_t::check (unsigned char *data_, size_t size_)
         if (!size_)
             return false;
 
-        //  If there's no corresponding slot for the first character
-        //  of the prefix, the message does not match.
-        unsigned char c = *data_;
-        if (c < current->min || c >= current->min + current->count)
+        //  If there's no child starting with the next character,
+        //  the message does not match.
+        int pos = find_child (*current, *data_);
+        if (pos < 0)
             return false;
 
-        //  Move to the next character.
-        if (current->count == 1)
-            current = current->next.node;
-        else {
-            current = current->next.table [c - current->min];
-            if (!current)
+        //  The whole label of the child has to match. The first character
+        //  is already known to match.
+        current = &nodes [children [pos]];
+        if (current->label_size > size_)
+            return false;
+        const unsigned char *label = &labels [current->label];
+        for (uint32_t i = 1; i != current->label_size; i++)
+            if (label [i] != data_ [i])
                 return false;
+        data_ += current->label_size;
+        size_ -= current->label_size;
+    }
+}
+
+bool zmq::prefix_tree_t::empty ()
+{
+    return !nodes [0].refcnt && !nodes [0].child_count;
+}
+
+int zmq::prefix_tree_t::find_child (const node_t &node_, unsigned char c_)
+{
+    if (!node_.child_count)
+        return -1;
+    const unsigned char *first = &keys [node_.first_child];
+
+    //  Small tables are scanned, large ones are searched using bisection.
+    if (node_.child_count <= 8) {
+        for (uint16_t i = 0; i != node_.child_count; i++)
+            if (first [i] == c_)
+                return (int) (node_.first_child + i);
+        return -1;
+    }
+
+    int low = 0;
+    int high = node_.child_count - 1;
+    while (low <= high) {
+        int mid = (low + high) / 2;
+        if (first [mid] == c_)
+            return (int) node_.first_child + mid;
+        if (first [mid] < c_)
+            low = mid + 1;
+        else
+            high = mid - 1;
+    }
+    return -1;
+}
+
+void zmq::prefix_tree_t::add_child (uint32_t node_, uint32_t child_)
+{
+    unsigned char c = labels [nodes [child_].label];
+    node_t &node = nodes [node_];
+
+    //  If the child table is full, move it to the end of the storage
+    //  and double its capacity.
+    if (node.child_count == node.child_capacity) {
+        uint16_t capacity = node.child_capacity ? node.child_capacity * 2 : 2;
+        uint32_t first_child = (uint32_t) children.size ();
+        children.resize (first_child + capacity);
+        keys.resize (first_child + capacity);
+        if (node.child_count) {
+            memcpy (&children [first_child], &children [node.first_child],
+                node.child_count * sizeof (uint32_t));
+            memcpy (&keys [first_child], &keys [node.first_child],
+                node.child_count);
         }
-        data_++;
-        size_--;
+        garbage += node.child_capacity * 5;
+        node.first_child = first_child;
+        node.child_capacity = capacity;
     }
+
+    //  Keep the table sorted by the first character.
+    uint32_t *table = &children [node.first_child];
+    unsigned char *first = &keys [node.first_child];
+    uint16_t pos = 0;
+    while (pos != node.child_count && first [pos] < c)
+        pos++;
+    memmove (table + pos + 1, table + pos,
+        (node.child_count - pos) * sizeof (uint32_t));
+    memmove (first + pos + 1, first + pos, node.child_count - pos);
+    table [pos] = child_;
+    first [pos] = c;
+    node.child_count++;
+}
+
+void zmq::prefix_tree_t::rm_child (uint32_t node_, unsigned char c_)
+{
+    node_t &node = nodes [node_];
+    int pos = find_child (node, c_);
+    zmq_assert (pos >= 0);
+    uint16_t index = (uint16_t) (pos - node.first_child);
+    uint32_t *table = &children [node.first_child];
+    unsigned char *first = &keys [node.first_child];
+    memmove (table + index, table + index + 1,
+        (node.child_count - index - 1) * sizeof (uint32_t));
+    memmove (first + index, first + index + 1, node.child_count - index - 1);
+    node.child_count--;
+}
+
+void zmq::prefix_tree_t::merge (uint32_t node_)
+{
+    zmq_assert (node_ != 0 && nodes [node_].child_count == 1);
+    uint32_t child = children [nodes [node_].first_child];
+
+    //  Labels of a split node and its child are adjacent in the storage.
+    //  Otherwise a new label has to be allocated.
+    uint32_t label_size = nodes [node_].label_size + nodes [child].label_size;
+    if (nodes [node_].label + nodes [node_].label_size !=
+          nodes [child].label) {
+        std::vector <unsigned char> label (label_size);
+        memcpy (&label [0], &labels [nodes [node_].label],
+            nodes [node_].label_size);
+        memcpy (&label [nodes [node_].label_size],
+            &labels [nodes [child].label], nodes [child].label_size);
+        garbage += label_size;
+        nodes [node_].label = alloc_label (&label [0], label_size);
+    }
+    nodes [node_].label_size = label_size;
+
+    //  The node takes over the subscriptions and children of the child.
+    garbage += nodes [node_].child_capacity * 5;
+    nodes [node_].refcnt = nodes [child].refcnt;
+    nodes [node_].first_child = nodes [child].first_child;
+    nodes [node_].child_count = nodes [child].child_count;
+    nodes [node_].child_capacity = nodes [child].child_capacity;
+    nodes [child].label_size = 0;
+    nodes [child].child_capacity = 0;
+    free_node (child);
+}
+
+uint32_t zmq::prefix_tree_t::alloc_node ()
+{
+    uint32_t node;
+    if (!free_nodes.empty ()) {
+        node = free_nodes.back ();
+        free_nodes.pop_back ();
+    }
+    else {
+        node = (uint32_t) nodes.size ();
+        nodes.push_back (node_t ());
+    }
+    nodes [node].refcnt = 0;
+    nodes [node].label = 0;
+    nodes [node].label_size = 0;
+    nodes [node].first_child = 0;
+    nodes [node].child_count = 0;
+    nodes [node].child_capacity = 0;
+    return node;
+}
+
+void zmq::prefix_tree_t::free_node (uint32_t node_)
+{
+    garbage += nodes [node_].label_size + nodes [node_].child_capacity * 5;
+    free_nodes.push_back (node_);
+}
+
+uint32_t zmq::prefix_tree_t::alloc_label (const unsigned char *data_,
+    size_t size_)
+{
+    uint32_t label = (uint32_t) labels.size ();
+    labels.insert (labels.end (), data_, data_ + size_);
+    return label;
+}
+
+void zmq::prefix_tree_t::compact ()
+{
+    std::vector <unsigned char> new_labels;
+    std::vector <uint32_t> new_children;
+    std::vector <unsigned char> new_keys;
+    new_labels.reserve (labels.size ());
+    new_children.reserve (children.size ());
+    new_keys.reserve (keys.size ());
+
+    compact_node (0, new_labels, new_children, new_keys);
+
+    labels.swap (new_labels);
+    children.swap (new_children);
+    keys.swap (new_keys);
+    garbage = 0;
+}
+
+void zmq::prefix_tree_t::compact_node (uint32_t node_,
+    std::vector <unsigned char> &labels_, std::vector <uint32_t> &children_,
+    std::vector <unsigned char> &keys_)
+{
+    node_t &node = nodes [node_];
+
+    uint32_t label = (uint32_t) labels_.size ();
+    if (node.label_size)
+        labels_.insert (labels_.end (), labels.begin () + node.label,
+            labels.begin () + node.label + node.label_size);
+    node.label = label;
+
+    uint32_t first_child = (uint32_t) children_.size ();
+    if (node.child_count) {
+        children_.insert (children_.end (),
+            children.begin () + node.first_child,
+            children.begin () + node.first_child + node.child_count);
+        keys_.insert (keys_.end (), keys.begin () + node.first_child,
+            keys.begin () + node.first_child + node.child_count);
+    }
+    node.first_child = first_child;
+    node.child_capacity = node.child_count;
+
+    for (uint16_t i = 0; i != node.child_count; i++)
+        compact_node (children_ [first_child + i], labels_, children_, keys_);
 }
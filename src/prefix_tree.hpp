@@ -21,12 +21,20 @@
 #define __ZMQ_PREFIX_TREE_HPP_INCLUDED__
 
 #include <stddef.h>
+#include <vector>
 
 #include "stdint.hpp"
 
 namespace zmq
 {
 
+    //  Set of subscription prefixes with reference counting. The prefixes
+    //  are stored in a path-compressed radix tree, i.e. each node holds
+    //  a whole run of characters rather than a single one. All the nodes,
+    //  edge labels and child tables live in a few contiguous arrays and
+    //  refer to each other by index, so that the tree needs only a handful
+    //  of heap allocations and stays compact in memory.
+
     class prefix_tree_t
     {
     public:
@@ -38,18 +46,75 @@ namespace zmq
         bool rm (unsigned char *prefix_, size_t size_);
         bool check (unsigned char *data_, size_t size_);
 
+        //  Returns true if there are no subscriptions in the tree.
+        bool empty ();
+
     private:
 
-        uint32_t refcnt;
-        unsigned char min;
-        unsigned char count;
-        union {
-            class prefix_tree_t *node;
-            class prefix_tree_t **table;
-        } next;
+        struct node_t
+        {
+            //  Number of subscriptions ending at this node.
+            uint32_t refcnt;
+
+            //  Characters on the edge leading to this node. Stored in
+            //  'labels' array.
+            uint32_t label;
+            uint32_t label_size;
+
+            //  Children of the node. Their indices are stored in 'children'
+            //  array, their first characters, in ascending order, at the same
+            //  positions in 'keys' array.
+            uint32_t first_child;
+            uint16_t child_count;
+            uint16_t child_capacity;
+        };
+
+        //  Returns position of the child starting with character c_ in
+        //  'children' array, or -1 if there's no such child.
+        int find_child (const node_t &node_, unsigned char c_);
+
+        //  Adds the child to the node, growing its child table if needed.
+        void add_child (uint32_t node_, uint32_t child_);
+
+        //  Removes the child starting with character c_ from the node.
+        void rm_child (uint32_t node_, unsigned char c_);
+
+        //  Merges the node with its only child so that the tree stays
+        //  path-compressed.
+        void merge (uint32_t node_);
+
+        //  Allocation and deallocation of nodes and labels.
+        uint32_t alloc_node ();
+        void free_node (uint32_t node_);
+        uint32_t alloc_label (const unsigned char *data_, size_t size_);
+
+        //  Rebuilds 'labels', 'children' and 'keys' arrays so that they
+        //  don't contain unused space.
+        void compact ();
+        void compact_node (uint32_t node_, std::vector <unsigned char> &labels_,
+            std::vector <uint32_t> &children_,
+            std::vector <unsigned char> &keys_);
+
+        //  Nodes of the tree. Root is always at index 0.
+        std::vector <node_t> nodes;
+
+        //  Indices of unused entries in 'nodes' array.
+        std::vector <uint32_t> free_nodes;
+
+        //  Storage for edge labels and child tables.
+        std::vector <unsigned char> labels;
+        std::vector <uint32_t> children;
+        std::vector <unsigned char> keys;
+
+        //  Amount of space in 'labels' and 'children' arrays that is
+        //  no longer used. Once it exceeds the space used, the arrays
+        //  are compacted.
+        size_t garbage;
+
+        prefix_tree_t (const prefix_tree_t&);
+        void operator = (const prefix_tree_t&);
     };
 
 }
 
 #endif
-
@@ -17,65 +17,137 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <new>
+#include <algorithm>
+
 #include "../include/zmq.h"
 
 #include "pub.hpp"
 #include "err.hpp"
 #include "msg_content.hpp"
+#include "subscription.hpp"
 #include "pipe.hpp"
 
 zmq::pub_t::pub_t (class app_thread_t *parent_) :
     socket_base_t (parent_),
-    active (0)
+    active (0),
+    more (false)
 {
     options.requires_in = false;
     options.requires_out = true;
+    options.requires_subscriptions = true;
 }
 
 zmq::pub_t::~pub_t ()
 {
-    for (pipes_t::size_type i = 0; i != pipes.size (); i++)
-        pipes [i]->term ();
-    pipes.clear ();
+    //  Subscribers with no outbound pipe are not in the subscribers array.
+    for (inpipes_t::iterator it = inpipes.begin (); it != inpipes.end ();
+          it++) {
+        it->first->term ();
+        if (!it->second->outpipe) {
+            delete it->second->subscriptions;
+            delete it->second;
+        }
+    }
+    inpipes.clear ();
+
+    for (subscribers_t::size_type i = 0; i != subscribers.size (); i++) {
+        subscribers [i]->outpipe->term ();
+        delete subscribers [i]->subscriptions;
+        delete subscribers [i];
+    }
+    subscribers.clear ();
+    outpipes.clear ();
 }
 
 void zmq::pub_t::xattach_pipes (class reader_t *inpipe_,
     class writer_t *outpipe_, const blob_t &peer_identity_)
 {
-    zmq_assert (!inpipe_);
-    pipes.push_back (outpipe_);
-    pipes.swap (active, pipes.size () - 1);
+    zmq_assert (outpipe_);
+
+    subscriber_t *subscriber = new (std::nothrow) subscriber_t;
+    zmq_assert (subscriber);
+    subscriber->outpipe = outpipe_;
+    subscriber->inpipe = inpipe_;
+    subscriber->filtered = inpipe_ != NULL;
+    subscriber->subscriptions = new (std::nothrow) prefix_tree_t;
+    zmq_assert (subscriber->subscriptions);
+
+    subscribers.push_back (subscriber);
+    subscribers.swap (active, subscribers.size () - 1);
     active++;
+    outpipes.insert (outpipes_t::value_type (outpipe_, subscriber));
+
+    //  Subscriptions may have been already sent by the peer.
+    if (inpipe_) {
+        inpipes.insert (inpipes_t::value_type (inpipe_, subscriber));
+        process_subscriptions (subscriber);
+    }
 }
 
 void zmq::pub_t::xdetach_inpipe (class reader_t *pipe_)
 {
-    zmq_assert (false);
+    inpipes_t::iterator it = inpipes.find (pipe_);
+    zmq_assert (it != inpipes.end ());
+    subscriber_t *subscriber = it->second;
+    inpipes.erase (it);
+
+    //  The subscriber is deallocated once both its pipes are detached.
+    subscriber->inpipe = NULL;
+    if (!subscriber->outpipe) {
+        delete subscriber->subscriptions;
+        delete subscriber;
+    }
 }
 
 void zmq::pub_t::xdetach_outpipe (class writer_t *pipe_)
 {
-    //  Remove the pipe from the list; adjust number of active pipes
-    //  accordingly.
-    if (pipes.index (pipe_) < active)
+    outpipes_t::iterator it = outpipes.find (pipe_);
+    zmq_assert (it != outpipes.end ());
+    subscriber_t *subscriber = it->second;
+    outpipes.erase (it);
+
+    //  Remove the subscriber from the list; adjust number of active
+    //  subscribers accordingly.
+    if (subscribers.index (subscriber) < active) {
         active--;
-    pipes.erase (pipe_);
+        subscribers.swap (subscribers.index (subscriber), active);
+    }
+    subscribers.erase (subscriber);
+
+    //  The subscriber may be detached in the middle of a multipart message.
+    matching_t::iterator mit =
+        std::find (matching.begin (), matching.end (), subscriber);
+    if (mit != matching.end ())
+        matching.erase (mit);
+
+    //  The subscriber is deallocated once both its pipes are detached.
+    subscriber->outpipe = NULL;
+    if (!subscriber->inpipe) {
+        delete subscriber->subscriptions;
+        delete subscriber;
+    }
 }
 
 void zmq::pub_t::xkill (class reader_t *pipe_)
 {
-    zmq_assert (false);
+    //  There are no more subscriptions in the pipe. Nothing to do as
+    //  the pipe is revived once new subscriptions arrive.
 }
 
 void zmq::pub_t::xrevive (class reader_t *pipe_)
 {
-    zmq_assert (false);
+    inpipes_t::iterator it = inpipes.find (pipe_);
+    zmq_assert (it != inpipes.end ());
+    process_subscriptions (it->second);
 }
 
 void zmq::pub_t::xrevive (class writer_t *pipe_)
 {
-    //  Move the pipe to the list of active pipes.
-    pipes.swap (pipes.index (pipe_), active);
+    //  Move the subscriber to the list of active subscribers.
+    outpipes_t::iterator it = outpipes.find (pipe_);
+    zmq_assert (it != outpipes.end ());
+    subscribers.swap (subscribers.index (it->second), active);
     active++;
 }
 
@@ -88,8 +160,27 @@ int zmq::pub_t::xsetsockopt (int option_, const void *optval_,
 
 int zmq::pub_t::xsend (zmq_msg_t *msg_, int flags_)
 {
-    //  If there are no active pipes available, simply drop the message.
-    if (active == 0) {
+    //  Find the subscribers interested in the message. Subsequent parts of
+    //  the message go to the same subscribers as the first one.
+    if (!more) {
+        matching.clear ();
+        unsigned char *data = (unsigned char*) zmq_msg_data (msg_);
+        size_t size = zmq_msg_size (msg_);
+        for (subscribers_t::size_type i = 0; i != active; i++)
+            if (match (subscribers [i], data, size))
+                matching.push_back (subscribers [i]);
+
+        //  Subscribers over their high water mark are skipped till they
+        //  catch up. The messages they are interested in are dropped.
+        for (subscribers_t::size_type i = active; i != subscribers.size ();
+              i++)
+            if (match (subscribers [i], data, size))
+                drops++;
+    }
+    more = msg_->flags & ZMQ_MSG_MORE;
+
+    //  If there are no matching subscribers, simply drop the message.
+    if (matching.empty ()) {
         int rc = zmq_msg_close (msg_);
         zmq_assert (rc == 0);
         rc = zmq_msg_init (msg_);
@@ -101,8 +192,8 @@ int zmq::pub_t::xsend (zmq_msg_t *msg_, int flags_)
 
     //  For VSMs the copying is straighforward.
     if (content == (msg_content_t*) ZMQ_VSM) {
-        for (pipes_t::size_type i = 0; i != active;)
-            if (write (pipes [i], msg_))
+        for (matching_t::size_type i = 0; i != matching.size ();)
+            if (write (i, msg_, flags_))
                 i++;
         int rc = zmq_msg_init (msg_);
         zmq_assert (rc == 0);
@@ -112,8 +203,8 @@ int zmq::pub_t::xsend (zmq_msg_t *msg_, int flags_)
     //  Optimisation for the case when there's only a single pipe
     //  to send the message to - no refcount adjustment i.e. no atomic
     //  operations are needed.
-    if (active == 1) {
-        if (!write (pipes [0], msg_)) {
+    if (matching.size () == 1) {
+        if (!write (0, msg_, flags_)) {
             int rc = zmq_msg_close (msg_);
             zmq_assert (rc == 0);
         }
@@ -126,15 +217,15 @@ int zmq::pub_t::xsend (zmq_msg_t *msg_, int flags_)
     //  to deal with reference counting. First add N-1 references to
     //  the content (we are holding one reference anyway, that's why -1).
     if (msg_->flags & ZMQ_MSG_SHARED)
-        content->refcnt.add (active - 1);
+        content->refcnt.add (matching.size () - 1);
     else {
-        content->refcnt.set (active);
+        content->refcnt.set (matching.size ());
         msg_->flags |= ZMQ_MSG_SHARED;
     }
 
     //  Push the message to all destinations.
-    for (pipes_t::size_type i = 0; i != active;) {
-        if (!write (pipes [i], msg_))
+    for (matching_t::size_type i = 0; i != matching.size ();) {
+        if (!write (i, msg_, flags_))
             content->refcnt.sub (1);
         else
             i++;
@@ -153,6 +244,12 @@ int zmq::pub_t::xrecv (zmq_msg_t *msg_, int flags_)
     return -1;
 }
 
+void zmq::pub_t::xflush ()
+{
+    for (subscribers_t::size_type i = 0; i != subscribers.size (); i++)
+        subscribers [i]->outpipe->flush ();
+}
+
 bool zmq::pub_t::xhas_in ()
 {
     return false;
@@ -163,15 +260,68 @@ bool zmq::pub_t::xhas_out ()
     return true;
 }
 
-bool zmq::pub_t::write (class writer_t *pipe_, zmq_msg_t *msg_)
+void zmq::pub_t::process_subscriptions (subscriber_t *subscriber_)
+{
+    //  Note that reading the delimiter detaches the pipe and possibly
+    //  deallocates the subscriber, so it mustn't be touched afterwards.
+    reader_t *pipe = subscriber_->inpipe;
+    zmq_msg_t msg;
+    zmq_msg_init (&msg);
+    while (true) {
+        zmq_msg_close (&msg);
+        if (!pipe->read (&msg))
+            break;
+
+        unsigned char *data = (unsigned char*) zmq_msg_data (&msg);
+        size_t size = zmq_msg_size (&msg);
+        if (!size)
+            continue;
+
+        switch (data [0]) {
+        case subscribe_command:
+            subscriber_->subscriptions->add (data + 1, size - 1);
+            break;
+        case unsubscribe_command:
+            subscriber_->subscriptions->rm (data + 1, size - 1);
+            break;
+        case reset_subscriptions_command:
+            delete subscriber_->subscriptions;
+            subscriber_->subscriptions = new (std::nothrow) prefix_tree_t;
+            zmq_assert (subscriber_->subscriptions);
+            subscriber_->exact_subscriptions.clear ();
+            break;
+        case subscribe_exact_command:
+            subscriber_->exact_subscriptions.add (data + 1, size - 1);
+            break;
+        case unsubscribe_exact_command:
+            subscriber_->exact_subscriptions.rm (data + 1, size - 1);
+            break;
+        }
+    }
+}
+
+bool zmq::pub_t::match (subscriber_t *subscriber_, unsigned char *data_,
+    size_t size_)
 {
-    if (!pipe_->write (msg_)) {
+    return !subscriber_->filtered ||
+        subscriber_->exact_subscriptions.check (data_, size_) ||
+        (!subscriber_->subscriptions->empty () &&
+        subscriber_->subscriptions->check (data_, size_));
+}
+
+bool zmq::pub_t::write (matching_t::size_type index_, zmq_msg_t *msg_,
+    int flags_)
+{
+    subscriber_t *subscriber = matching [index_];
+    if (!subscriber->outpipe->write (msg_)) {
+        drops++;
         active--;
-        pipes.swap (pipes.index (pipe_), active);
+        subscribers.swap (subscribers.index (subscriber), active);
+        matching [index_] = matching.back ();
+        matching.pop_back ();
         return false;
     }
-    if (!(msg_->flags & ZMQ_MSG_MORE))
-        pipe_->flush ();
+    if (!(msg_->flags & ZMQ_MSG_MORE) && !(flags_ & send_noflush))
+        subscriber->outpipe->flush ();
     return true;
 }
-
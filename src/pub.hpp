@@ -20,8 +20,14 @@
 #ifndef __ZMQ_PUB_HPP_INCLUDED__
 #define __ZMQ_PUB_HPP_INCLUDED__
 
+#include <map>
+#include <vector>
+
 #include "socket_base.hpp"
+#include "prefix_tree.hpp"
+#include "topic_hash.hpp"
 #include "yarray.hpp"
+#include "yarray_item.hpp"
 
 namespace zmq
 {
@@ -44,22 +50,70 @@ namespace zmq
         int xsetsockopt (int option_, const void *optval_, size_t optvallen_);
         int xsend (zmq_msg_t *msg_, int flags_);
         int xrecv (zmq_msg_t *msg_, int flags_);
+        void xflush ();
         bool xhas_in ();
         bool xhas_out ();
 
     private:
 
-        //  Write the message to the pipe. Make the pipe inactive if writing
-        //  fails. In such a case false is returned.
-        bool write (class writer_t *pipe_, zmq_msg_t *msg_);
-
-        //  Outbound pipes, i.e. those the socket is sending messages to.
-        typedef yarray_t <class writer_t> pipes_t;
-        pipes_t pipes;
-
-        //  Number of active pipes. All the active pipes are located at the
-        //  beginning of the pipes array.
-        pipes_t::size_type active;
+        //  Peer the messages are published to.
+        struct subscriber_t : public yarray_item_t
+        {
+            //  Pipe to send the messages to.
+            class writer_t *outpipe;
+
+            //  Pipe to receive the subscriptions from.
+            class reader_t *inpipe;
+
+            //  If false, the transport can't forward subscriptions (PGM)
+            //  and all the messages are sent to the peer.
+            bool filtered;
+
+            //  Subscriptions received from the peer.
+            prefix_tree_t *subscriptions;
+            topic_hash_t exact_subscriptions;
+        };
+
+        //  Applies all the subscription commands available in the pipe
+        //  from the subscriber.
+        void process_subscriptions (subscriber_t *subscriber_);
+
+        //  Returns true if the subscriber is interested in the message
+        //  starting with the data supplied.
+        bool match (subscriber_t *subscriber_, unsigned char *data_,
+            size_t size_);
+
+        //  Write the message to the subscriber with the specified index
+        //  in the 'matching' array. Make the subscriber inactive and remove
+        //  it from the array if writing fails. In such a case false is
+        //  returned. The pipe is flushed unless send_noflush is set
+        //  in flags_.
+        bool write (std::vector <subscriber_t*>::size_type index_,
+            zmq_msg_t *msg_, int flags_);
+
+        //  Subscribers, i.e. the peers the socket is sending messages to.
+        typedef yarray_t <subscriber_t> subscribers_t;
+        subscribers_t subscribers;
+
+        //  Number of active subscribers. All the active subscribers are
+        //  located at the beginning of the subscribers array.
+        subscribers_t::size_type active;
+
+        //  Subscribers the pipes belong to.
+        typedef std::map <class writer_t*, subscriber_t*> outpipes_t;
+        outpipes_t outpipes;
+        typedef std::map <class reader_t*, subscriber_t*> inpipes_t;
+        inpipes_t inpipes;
+
+        //  Active subscribers the message being sent is delivered to.
+        //  Matching is done on the first part of the message. Subsequent
+        //  parts are delivered to the same subscribers.
+        typedef std::vector <subscriber_t*> matching_t;
+        matching_t matching;
+
+        //  If true, part of a multipart message was already sent, but
+        //  there are following parts still to be sent.
+        bool more;
 
         pub_t (const pub_t&);
         void operator = (const pub_t&);
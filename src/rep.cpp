@@ -241,6 +241,12 @@ int zmq::rep_t::xrecv (zmq_msg_t *msg_, int flags_)
     return -1;
 }
 
+void zmq::rep_t::xflush ()
+{
+    //  As requests and replies alternate, there's never more than a single
+    //  reply to send. It is flushed as soon as it is complete.
+}
+
 bool zmq::rep_t::xhas_in ()
 {
     if (!sending_reply && more)
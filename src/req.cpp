@@ -244,6 +244,12 @@ int zmq::req_t::xrecv (zmq_msg_t *msg_, int flags_)
     return 0;
 }
 
+void zmq::req_t::xflush ()
+{
+    //  As requests and replies alternate, there's never more than a single
+    //  request to send. It is flushed as soon as it is complete.
+}
+
 bool zmq::req_t::xhas_in ()
 {
     if (receiving_reply && more)
@@ -132,16 +132,15 @@ void zmq::select_t::reset_pollout (handle_t handle_)
     FD_CLR (handle_, &source_set_out);
 }
 
-void zmq::select_t::add_timer (i_poll_events *events_)
+zmq::timer_wheel_t::handle_t zmq::select_t::add_timer (int timeout_,
+    i_poll_events *events_, int id_)
 {
-    timers.push_back (events_);
+    return timers.add (timeout_, events_, id_);
 }
 
-void zmq::select_t::cancel_timer (i_poll_events *events_)
+void zmq::select_t::cancel_timer (timer_wheel_t::handle_t handle_)
 {
-    timers_t::iterator it = std::find (timers.begin (), timers.end (), events_);
-    if (it != timers.end ())
-        timers.erase (it);
+    timers.cancel (handle_);
 }
 
 int zmq::select_t::get_load ()
@@ -168,14 +167,15 @@ void zmq::select_t::loop ()
         memcpy (&writefds, &source_set_out, sizeof source_set_out);
         memcpy (&exceptfds, &source_set_err, sizeof source_set_err);
 
-        //  Compute the timout interval. Select is free to overwrite the
-        //  value so we have to compute it each time anew.
-        timeval timeout = {max_timer_period / 1000,
-            (max_timer_period % 1000) * 1000};
+        //  Execute any due timers and compute the timout interval. Select
+        //  is free to overwrite the value so we have to compute it each
+        //  time anew.
+        int ms = timers.execute ();
+        timeval timeout = {ms / 1000, (ms % 1000) * 1000};
 
         //  Wait for events.
         int rc = select (maxfd + 1, &readfds, &writefds, &exceptfds,
-            timers.empty () ? NULL : &timeout);
+            ms == -1 ? NULL : &timeout);
 
 #ifdef ZMQ_HAVE_WINDOWS
         wsa_assert (rc != SOCKET_ERROR);
@@ -185,21 +185,6 @@ void zmq::select_t::loop ()
         errno_assert (rc != -1);
 #endif
 
-        //  Handle timer.
-        if (!rc) {
-
-            //  Use local list of timers as timer handlers may fill new timers
-            //  into the original array.
-            timers_t t;
-            std::swap (timers, t);
-
-            //  Trigger all the timers.
-            for (timers_t::iterator it = t.begin (); it != t.end (); it ++)
-                (*it)->timer_event ();
-
-            continue;
-        }
-
         for (fd_set_t::size_type i = 0; i < fds.size (); i ++) {
             if (fds [i].fd == retired_fd)
                 continue;
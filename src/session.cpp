@@ -18,17 +18,21 @@
 */
 
 #include <new>
+#include <string.h>
 
 #include "session.hpp"
 #include "i_engine.hpp"
 #include "err.hpp"
 #include "pipe.hpp"
+#include "subscription.hpp"
 
 zmq::session_t::session_t (object_t *parent_, socket_base_t *owner_,
       const options_t &options_) :
     owned_t (parent_, owner_),
     in_pipe (NULL),
     incomplete_in (false),
+    incomplete_out (false),
+    dropping (false),
     active (true),
     out_pipe (NULL),
     engine (NULL),
@@ -44,6 +48,9 @@ zmq::session_t::session_t (object_t *parent_, socket_base_t *owner_,
       const options_t &options_, const blob_t &peer_identity_) :
     owned_t (parent_, owner_),
     in_pipe (NULL),
+    incomplete_in (false),
+    incomplete_out (false),
+    dropping (false),
     active (true),
     out_pipe (NULL),
     engine (NULL),
@@ -70,6 +77,19 @@ zmq::session_t::~session_t ()
 
 bool zmq::session_t::read (::zmq_msg_t *msg_)
 {
+    //  On the subscriber side the in pipe carries subscriptions only. These
+    //  are processed by the session itself and forwarded from the queue.
+    if (options.requires_in && options.requires_subscriptions) {
+        if (commands.empty ())
+            return false;
+        int rc = zmq_msg_init_size (msg_, commands.front ().size ());
+        zmq_assert (rc == 0);
+        memcpy (zmq_msg_data (msg_), commands.front ().data (),
+            commands.front ().size ());
+        commands.pop_front ();
+        return true;
+    }
+
     if (!in_pipe || !active)
         return false;
 
@@ -82,7 +102,27 @@ bool zmq::session_t::read (::zmq_msg_t *msg_)
 
 bool zmq::session_t::write (::zmq_msg_t *msg_)
 {
+    bool more = msg_->flags & ZMQ_MSG_MORE;
+
+    //  Drop the messages the socket is not subscribed to straight away.
+    //  Subsequent parts of a message share the fate of the first one.
+    if (options.requires_in && options.requires_subscriptions) {
+        if (!incomplete_out) {
+            unsigned char *data = (unsigned char*) zmq_msg_data (msg_);
+            size_t size = zmq_msg_size (msg_);
+            dropping = !exact_subscriptions.check (data, size) &&
+                (subscriptions.empty () || !subscriptions.check (data, size));
+        }
+        if (dropping) {
+            incomplete_out = more;
+            zmq_msg_close (msg_);
+            zmq_msg_init (msg_);
+            return true;
+        }
+    }
+
     if (out_pipe && out_pipe->write (msg_)) {
+        incomplete_out = more;
         zmq_msg_init (msg_);
         return true;
     }
@@ -113,6 +153,7 @@ void zmq::session_t::detach (owned_t *reconnecter_)
         out_pipe->rollback ();
         out_pipe->flush ();
     }
+    incomplete_out = false;
 
     //  Remove any half-read message from the in pipe.
     if (in_pipe) {
@@ -156,6 +197,8 @@ void zmq::session_t::attach_pipes (class reader_t *inpipe_,
         in_pipe = inpipe_;
         active = true;
         in_pipe->set_endpoint (this);
+        if (options.requires_in && options.requires_subscriptions)
+            process_subscriptions ();
     }
 
     if (outpipe_) {
@@ -185,6 +228,11 @@ void zmq::session_t::revive (reader_t *pipe_)
 {
     zmq_assert (in_pipe == pipe_);
     active = true;
+    if (options.requires_in && options.requires_subscriptions) {
+        process_subscriptions ();
+        if (commands.empty ())
+            return;
+    }
     if (engine)
         engine->revive ();
 }
@@ -228,6 +276,13 @@ void zmq::session_t::process_unplug ()
 void zmq::session_t::process_attach (i_engine *engine_,
     const blob_t &peer_identity_)
 {
+    //  If the session is still connected, the new connection comes from
+    //  another peer using the same identity. Drop it.
+    if (engine) {
+        delete engine_;
+        return;
+    }
+
     if (!peer_identity.empty ()) {
 
         //  If both IDs are temporary, no checking is needed.
@@ -263,24 +318,54 @@ void zmq::session_t::process_attach (i_engine *engine_,
     reader_t *socket_reader = NULL;
     writer_t *socket_writer = NULL;
 
-    if (options.requires_in && !out_pipe) {
-        pipe_t *pipe = new (std::nothrow) pipe_t (owner, this,
-            options.hwm, options.lwm);
+    //  Pipes carrying subscriptions have no limits as subscriptions must
+    //  never be dropped.
+    if ((options.requires_in || options.requires_subscriptions) &&
+          !out_pipe) {
+        pipe_t *pipe = options.requires_in ?
+            new (std::nothrow) pipe_t (owner, this, options.hwm, options.lwm,
+            options.hwm_bytes, options.lwm_bytes, options.swap) :
+            new (std::nothrow) pipe_t (owner, this, 0, 0, 0, 0, 0);
         zmq_assert (pipe);
         out_pipe = &pipe->writer;
         out_pipe->set_endpoint (this);
         socket_reader = &pipe->reader;
     }
 
-    if (options.requires_out && !in_pipe) {
-        pipe_t *pipe = new (std::nothrow) pipe_t (this, owner,
-            options.hwm, options.lwm);
+    if ((options.requires_out || options.requires_subscriptions) &&
+          !in_pipe) {
+        pipe_t *pipe = options.requires_out ?
+            new (std::nothrow) pipe_t (this, owner, options.hwm, options.lwm,
+            options.hwm_bytes, options.lwm_bytes, options.swap) :
+            new (std::nothrow) pipe_t (this, owner, 0, 0, 0, 0, 0);
         zmq_assert (pipe);
         in_pipe = &pipe->reader;
         in_pipe->set_endpoint (this);
         socket_writer = &pipe->writer;
     }
 
+    //  The peer may be a new publisher or may still hold the subscriptions
+    //  from the previous connection. Either way, make it start from scratch.
+    if (options.requires_in && options.requires_subscriptions) {
+        process_subscriptions ();
+        commands.clear ();
+        if (options.forward_subscriptions) {
+            commands.push_back (blob_t (1, reset_subscriptions_command));
+            for (prefixes_t::iterator it = prefixes.begin ();
+                  it != prefixes.end (); it++) {
+                blob_t command (1, subscribe_command);
+                command.append (*it);
+                commands.push_back (command);
+            }
+            for (prefixes_t::iterator it = exact_topics.begin ();
+                  it != exact_topics.end (); it++) {
+                blob_t command (1, subscribe_exact_command);
+                command.append (*it);
+                commands.push_back (command);
+            }
+        }
+    }
+
     if (socket_reader || socket_writer)
         send_bind (owner, socket_reader, socket_writer, peer_identity);
 
@@ -290,3 +375,47 @@ void zmq::session_t::process_attach (i_engine *engine_,
     engine = engine_;
     engine->plug (this);
 }
+
+void zmq::session_t::process_subscriptions ()
+{
+    //  Note that reading the delimiter detaches the in pipe and that
+    //  the pipe must not be read after it was killed till it is revived.
+    zmq_msg_t msg;
+    zmq_msg_init (&msg);
+    while (in_pipe && active && in_pipe->read (&msg)) {
+        unsigned char *data = (unsigned char*) zmq_msg_data (&msg);
+        size_t size = zmq_msg_size (&msg);
+        if (size) {
+            if (data [0] == subscribe_command) {
+                subscriptions.add (data + 1, size - 1);
+                prefixes.insert (blob_t (data + 1, size - 1));
+            }
+            else if (data [0] == unsubscribe_command) {
+                prefixes_t::iterator it =
+                    prefixes.find (blob_t (data + 1, size - 1));
+                if (it != prefixes.end ()) {
+                    subscriptions.rm (data + 1, size - 1);
+                    prefixes.erase (it);
+                }
+            }
+            else if (data [0] == subscribe_exact_command) {
+                if (exact_subscriptions.add (data + 1, size - 1))
+                    exact_topics.insert (blob_t (data + 1, size - 1));
+            }
+            else if (data [0] == unsubscribe_exact_command) {
+                prefixes_t::iterator it =
+                    exact_topics.find (blob_t (data + 1, size - 1));
+                if (it != exact_topics.end ()) {
+                    exact_subscriptions.rm (data + 1, size - 1);
+                    exact_topics.erase (it);
+                }
+            }
+
+            //  While disconnected, the commands are not queued. All the
+            //  subscriptions are sent once the new connection is attached.
+            if (engine && options.forward_subscriptions)
+                commands.push_back (blob_t (data, size));
+        }
+        zmq_msg_close (&msg);
+    }
+}
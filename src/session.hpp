@@ -20,10 +20,15 @@
 #ifndef __ZMQ_SESSION_HPP_INCLUDED__
 #define __ZMQ_SESSION_HPP_INCLUDED__
 
+#include <set>
+#include <deque>
+
 #include "i_inout.hpp"
 #include "i_endpoint.hpp"
 #include "owned.hpp"
 #include "options.hpp"
+#include "prefix_tree.hpp"
+#include "topic_hash.hpp"
 #include "blob.hpp"
 
 namespace zmq
@@ -69,6 +74,10 @@ namespace zmq
         void process_attach (struct i_engine *engine_,
             const blob_t &peer_identity_);
 
+        //  Applies subscription commands sent by the socket (subscriber side
+        //  only) and queues them to be forwarded to the peer.
+        void process_subscriptions ();
+
         //  Inbound pipe, i.e. one the session is getting messages from.
         class reader_t *in_pipe;
 
@@ -76,6 +85,14 @@ namespace zmq
         //  is still in the in pipe.
         bool incomplete_in;
 
+        //  This flag is true if the remainder of the message being written
+        //  to the out pipe is still to arrive from the engine.
+        bool incomplete_out;
+
+        //  If true, the message being written doesn't match the subscriptions
+        //  and its remaining parts are dropped.
+        bool dropping;
+
         //  If true, in_pipe is active. Otherwise there are no messages to get.
         bool active;
 
@@ -95,6 +112,23 @@ namespace zmq
         //  Inherited socket options.
         options_t options;
 
+        //  Snapshot of the socket's subscriptions (subscriber side only).
+        //  Messages that don't match are dropped before they are written
+        //  to the out pipe.
+        prefix_tree_t subscriptions;
+        topic_hash_t exact_subscriptions;
+
+        //  The same subscriptions as a list. When a new connection is
+        //  attached they are sent to the peer anew, preceded by a reset
+        //  command so that the peer drops any stale subscriptions.
+        typedef std::multiset <blob_t> prefixes_t;
+        prefixes_t prefixes;
+        prefixes_t exact_topics;
+
+        //  Subscription commands waiting to be sent to the peer.
+        typedef std::deque <blob_t> commands_t;
+        commands_t commands;
+
         session_t (const session_t&);
         void operator = (const session_t&);
     };
@@ -37,12 +37,24 @@
 #include "platform.hpp"
 #include "pgm_sender.hpp"
 #include "pgm_receiver.hpp"
+#include "socket_poller.hpp"
+#include "clock.hpp"
 
 zmq::socket_base_t::socket_base_t (app_thread_t *parent_) :
     object_t (parent_),
+    options (parent_->get_dispatcher ()->get_socket_defaults ()),
+    drops (0),
     pending_term_acks (0),
     ticks (0),
+    msgs_sent (0),
+    msgs_received (0),
+    bytes_sent (0),
+    bytes_received (0),
+    hwm_stalls (0),
+    reconnects (0),
     app_thread (parent_),
+    poller (NULL),
+    poller_item (NULL),
     shutting_down (false),
     sent_seqnum (0),
     processed_seqnum (0),
@@ -67,6 +79,63 @@ int zmq::socket_base_t::setsockopt (int option_, const void *optval_,
     return options.setsockopt (option_, optval_, optvallen_);
 }
 
+int zmq::socket_base_t::getsockopt (int option_, void *optval_,
+    size_t *optvallen_)
+{
+    uint64_t value;
+    switch (option_) {
+    case ZMQ_MSGS_SENT:
+        value = msgs_sent;
+        break;
+    case ZMQ_MSGS_RECEIVED:
+        value = msgs_received;
+        break;
+    case ZMQ_BYTES_SENT:
+        value = bytes_sent;
+        break;
+    case ZMQ_BYTES_RECEIVED:
+        value = bytes_received;
+        break;
+    case ZMQ_HWM_STALLS:
+        value = hwm_stalls;
+        break;
+    case ZMQ_DROPS:
+        value = drops;
+        break;
+    case ZMQ_RECONNECTS:
+        value = reconnects.get ();
+        break;
+    case ZMQ_QUEUED:
+    case ZMQ_MAX_QUEUED:
+
+        //  The queue sizes are based on the last reader info received from
+        //  the peers. Process the pending commands to get recent values.
+        app_thread->process_commands (false, 0);
+        value = 0;
+        for (outpipes_t::size_type i = 0; i != outpipes.size (); i++) {
+            uint64_t size = outpipes [i]->queue_size ();
+            if (option_ == ZMQ_QUEUED)
+                value += size;
+            else if (size > value)
+                value = size;
+        }
+        break;
+    default:
+
+        //  Generic options can be read back. Socket-type-specific options
+        //  are write-only.
+        return options.getsockopt (option_, optval_, optvallen_);
+    }
+
+    if (*optvallen_ < sizeof (uint64_t)) {
+        errno = EINVAL;
+        return -1;
+    }
+    *((uint64_t*) optval_) = value;
+    *optvallen_ = sizeof (uint64_t);
+    return 0;
+}
+
 int zmq::socket_base_t::bind (const char *addr_)
 {
     //  Parse addr_ string.
@@ -153,17 +222,28 @@ int zmq::socket_base_t::connect (const char *addr_)
         pipe_t *in_pipe = NULL;
         pipe_t *out_pipe = NULL;
 
-        //  Create inbound pipe, if required.
+        //  Create inbound pipe, if required. Pipes carrying subscriptions
+        //  have no limits as subscriptions must never be dropped.
         if (options.requires_in) {
             in_pipe = new (std::nothrow) pipe_t (this, peer,
-                options.hwm, options.lwm);
+                options.hwm, options.lwm, options.hwm_bytes, options.lwm_bytes,
+                options.swap);
+            zmq_assert (in_pipe);
+        }
+        else if (options.requires_subscriptions) {
+            in_pipe = new (std::nothrow) pipe_t (this, peer, 0, 0, 0, 0, 0);
             zmq_assert (in_pipe);
         }
 
         //  Create outbound pipe, if required.
         if (options.requires_out) {
             out_pipe = new (std::nothrow) pipe_t (peer, this,
-                options.hwm, options.lwm);
+                options.hwm, options.lwm, options.hwm_bytes, options.lwm_bytes,
+                options.swap);
+            zmq_assert (out_pipe);
+        }
+        else if (options.requires_subscriptions) {
+            out_pipe = new (std::nothrow) pipe_t (peer, this, 0, 0, 0, 0, 0);
             zmq_assert (out_pipe);
         }
 
@@ -180,10 +260,20 @@ int zmq::socket_base_t::connect (const char *addr_)
         return 0;
     }
 
+    //  Multicast is uni-directional, thus subscriptions can't be forwarded
+    //  upstream. The publisher sends all the messages and the subscriber's
+    //  session filters them in such a case.
+    options_t session_options (options);
+    if (addr_type == "pgm" || addr_type == "epgm") {
+        session_options.forward_subscriptions = false;
+        if (options.requires_out)
+            session_options.requires_subscriptions = false;
+    }
+
     //  Create unnamed session.
     io_thread_t *io_thread = choose_io_thread (options.affinity);
     session_t *session = new (std::nothrow) session_t (io_thread,
-        this, options);
+        this, session_options);
     zmq_assert (session);
 
     //  If 'immediate connect' feature is required, we'll created the pipes
@@ -197,15 +287,25 @@ int zmq::socket_base_t::connect (const char *addr_)
         //  Create inbound pipe, if required.
         if (options.requires_in) {
             in_pipe = new (std::nothrow) pipe_t (this, session,
-                options.hwm, options.lwm);
+                options.hwm, options.lwm, options.hwm_bytes, options.lwm_bytes,
+                options.swap);
             zmq_assert (in_pipe);
 
         }
+        else if (session_options.requires_subscriptions) {
+            in_pipe = new (std::nothrow) pipe_t (this, session, 0, 0, 0, 0, 0);
+            zmq_assert (in_pipe);
+        }
 
         //  Create outbound pipe, if required.
         if (options.requires_out) {
             out_pipe = new (std::nothrow) pipe_t (session, this,
-                options.hwm, options.lwm);
+                options.hwm, options.lwm, options.hwm_bytes, options.lwm_bytes,
+                options.swap);
+            zmq_assert (out_pipe);
+        }
+        else if (session_options.requires_subscriptions) {
+            out_pipe = new (std::nothrow) pipe_t (session, this, 0, 0, 0, 0, 0);
             zmq_assert (out_pipe);
         }
 
@@ -316,13 +416,23 @@ int zmq::socket_base_t::send (::zmq_msg_t *msg_, int flags_)
     if (flags_ & ZMQ_MORE)
         msg_->flags |= ZMQ_MSG_MORE;
 
+    //  Sending may change the events to be reported by the poller.
+    notify_poller ();
+
     //  Process pending commands, if any.
-    app_thread->process_commands (false, true);
+    app_thread->process_commands (false, options.max_command_delay);
 
-    //  Try to send the message.
+    //  Try to send the message. Sending detaches the message from its
+    //  data so the size has to be retrieved beforehand.
+    size_t size = zmq_msg_size (msg_);
     int rc = xsend (msg_, flags_);
-    if (rc == 0)
+    if (rc == 0) {
+        msgs_sent++;
+        bytes_sent += size;
         return 0;
+    }
+    if (errno == EAGAIN)
+        hwm_stalls++;
 
     //  In case of non-blocking send we'll simply propagate
     //  the error - including EAGAIN - upwards.
@@ -334,14 +444,19 @@ int zmq::socket_base_t::send (::zmq_msg_t *msg_, int flags_)
     while (rc != 0) {
         if (errno != EAGAIN)
             return -1;
-        app_thread->process_commands (true, false);
+        app_thread->process_commands (true, 0);
         rc = xsend (msg_, flags_);
     }
+    msgs_sent++;
+    bytes_sent += size;
     return 0;
 }
 
 int zmq::socket_base_t::recv (::zmq_msg_t *msg_, int flags_)
 {
+    //  Receiving may change the events to be reported by the poller.
+    notify_poller ();
+
     //  Get the message.
     int rc = xrecv (msg_, flags_);
     int err = errno;
@@ -354,14 +469,17 @@ int zmq::socket_base_t::recv (::zmq_msg_t *msg_, int flags_)
     //  Note that 'recv' uses different command throttling algorithm (the one
     //  described above) from the one used by 'send'. This is because counting
     //  ticks is more efficient than doing rdtsc all the time.
-    if (++ticks == inbound_poll_rate) {
-        app_thread->process_commands (false, false);
+    if (++ticks >= options.inbound_poll_rate) {
+        app_thread->process_commands (false, 0);
         ticks = 0;
     }
 
     //  If we have the message, return immediately.
-    if (rc == 0)
+    if (rc == 0) {
+        msgs_received++;
+        bytes_received += zmq_msg_size (msg_);
         return 0;
+    }
 
     //  If we don't have the message, restore the original cause of the problem.
     errno = err;
@@ -372,9 +490,26 @@ int zmq::socket_base_t::recv (::zmq_msg_t *msg_, int flags_)
     if (flags_ & ZMQ_NOBLOCK) {
         if (errno != EAGAIN)
             return -1;
-        app_thread->process_commands (false, false);
+        app_thread->process_commands (false, 0);
+        ticks = 0;
+        rc = xrecv (msg_, flags_);
+        if (rc == 0) {
+            msgs_received++;
+            bytes_received += zmq_msg_size (msg_);
+        }
+        return rc;
+    }
+
+    //  If required, busy-poll for the message for a while before going to
+    //  sleep. Waking up a sleeping thread costs more than the spinning when
+    //  the message arrives shortly.
+    if (options.rcvspin && errno == EAGAIN) {
+        uint64_t deadline = zmq::now_us () + options.rcvspin;
+        do {
+            app_thread->process_commands (false, 0);
+            rc = xrecv (msg_, flags_);
+        } while (rc != 0 && errno == EAGAIN && zmq::now_us () < deadline);
         ticks = 0;
-        return xrecv (msg_, flags_);
     }
 
     //  In blocking scenario, commands are processed over and over again until
@@ -382,17 +517,100 @@ int zmq::socket_base_t::recv (::zmq_msg_t *msg_, int flags_)
     while (rc != 0) {
         if (errno != EAGAIN)
             return -1;
-        app_thread->process_commands (true, false);
+        app_thread->process_commands (true, 0);
         rc = xrecv (msg_, flags_);
         ticks = 0;
     }
+    msgs_received++;
+    bytes_received += zmq_msg_size (msg_);
     return 0;
 }
 
+int zmq::socket_base_t::sendv (::zmq_msg_t *msgs_, size_t count_, int flags_)
+{
+    //  ZMQ_MORE applies to the last message of the batch.
+    if (count_ && (flags_ & ZMQ_MORE))
+        msgs_ [count_ - 1].flags |= ZMQ_MSG_MORE;
+
+    //  Sending may change the events to be reported by the poller.
+    notify_poller ();
+
+    //  Process pending commands, if any. This is done once for the whole
+    //  batch.
+    app_thread->process_commands (false, options.max_command_delay);
+
+    //  Write the messages to the pipes without flushing them.
+    size_t sent = 0;
+    while (sent != count_) {
+        size_t size = zmq_msg_size (&msgs_ [sent]);
+        if (xsend (&msgs_ [sent], flags_ | send_noflush) == 0) {
+            msgs_sent++;
+            bytes_sent += size;
+            sent++;
+            continue;
+        }
+        if (errno != EAGAIN)
+            break;
+        hwm_stalls++;
+        if (flags_ & ZMQ_NOBLOCK)
+            break;
+
+        //  The messages written so far have to be passed to the peers
+        //  before waiting, otherwise the pipes would never get emptied.
+        xflush ();
+        app_thread->process_commands (true, 0);
+    }
+
+    //  Flush all the messages written at once.
+    int err = errno;
+    xflush ();
+    errno = err;
+
+    //  Fail only if no message was sent at all.
+    if (count_ && !sent)
+        return -1;
+    return (int) sent;
+}
+
+int zmq::socket_base_t::recvv (::zmq_msg_t *msgs_, size_t count_, int flags_)
+{
+    if (!count_)
+        return 0;
+
+    //  Get the first message the same way as a single message is received,
+    //  i.e. wait for it in the blocking mode.
+    int rc = recv (&msgs_ [0], flags_);
+    if (rc != 0)
+        return -1;
+
+    //  Get the messages that are immediately available. Commands are not
+    //  processed for each message; they are processed once per
+    //  inbound_poll_rate messages as with individual calls to recv.
+    size_t received = 1;
+    while (received != count_ &&
+          xrecv (&msgs_ [received], flags_ | ZMQ_NOBLOCK) == 0) {
+        msgs_received++;
+        bytes_received += zmq_msg_size (&msgs_ [received]);
+        received++;
+    }
+
+    ticks += received - 1;
+    if (ticks >= options.inbound_poll_rate) {
+        app_thread->process_commands (false, 0);
+        ticks = 0;
+    }
+
+    return (int) received;
+}
+
 int zmq::socket_base_t::close ()
 {
     shutting_down = true;
 
+    //  Unregister the socket from the persistent poller.
+    if (poller)
+        poller->remove_socket (this);
+
     //  Let the thread know that the socket is no longer available.
     app_thread->remove_socket (this);
 
@@ -408,7 +626,7 @@ int zmq::socket_base_t::close ()
     //  Wait till all undelivered commands are delivered. This should happen
     //  very quickly. There's no way to wait here for extensive period of time.
     while (processed_seqnum != sent_seqnum.get ())
-        app_thread->process_commands (true, false);
+        app_thread->process_commands (true, 0);
 
     while (true) {
 
@@ -430,7 +648,7 @@ int zmq::socket_base_t::close ()
 
         //  Process commands till we get all the termination acknowledgements.
         while (pending_term_acks)
-            app_thread->process_commands (true, false);
+            app_thread->process_commands (true, 0);
     }
 
     //  Check whether there are no session leaks.
@@ -454,6 +672,12 @@ void zmq::socket_base_t::inc_seqnum ()
     sent_seqnum.add (1);
 }
 
+void zmq::socket_base_t::inc_reconnects ()
+{
+    //  NB: This function is called from an I/O thread!
+    reconnects.add (1);
+}
+
 zmq::app_thread_t *zmq::socket_base_t::get_thread ()
 {
     return app_thread;
@@ -469,6 +693,29 @@ bool zmq::socket_base_t::has_out ()
     return xhas_out ();
 }
 
+void zmq::socket_base_t::set_poller (socket_poller_t *poller_, void *item_)
+{
+    poller = poller_;
+    poller_item = item_;
+}
+
+zmq::socket_poller_t *zmq::socket_base_t::get_poller ()
+{
+    return poller;
+}
+
+void zmq::socket_base_t::notify_poller ()
+{
+#if defined ZMQ_HAVE_LINUX || defined ZMQ_HAVE_FREEBSD ||\
+    defined ZMQ_HAVE_OPENBSD || defined ZMQ_HAVE_SOLARIS ||\
+    defined ZMQ_HAVE_OSX || defined ZMQ_HAVE_QNXNTO ||\
+    defined ZMQ_HAVE_HPUX || defined ZMQ_HAVE_AIX ||\
+    defined ZMQ_HAVE_NETBSD
+    if (poller)
+        poller->mark (poller_item);
+#endif
+}
+
 bool zmq::socket_base_t::register_session (const blob_t &peer_identity_,
     session_t *session_)
 {
@@ -545,16 +792,19 @@ zmq::session_t *zmq::socket_base_t::find_session (uint64_t ordinal_)
 void zmq::socket_base_t::kill (reader_t *pipe_)
 {
     xkill (pipe_);
+    notify_poller ();
 }
 
 void zmq::socket_base_t::revive (reader_t *pipe_)
 {
     xrevive (pipe_);
+    notify_poller ();
 }
 
 void zmq::socket_base_t::revive (writer_t *pipe_)
 {
     xrevive (pipe_);
+    notify_poller ();
 }
 
 void zmq::socket_base_t::attach_pipes (class reader_t *inpipe_,
@@ -562,21 +812,30 @@ void zmq::socket_base_t::attach_pipes (class reader_t *inpipe_,
 {
     if (inpipe_)
         inpipe_->set_endpoint (this);
-    if (outpipe_)
+    if (outpipe_) {
         outpipe_->set_endpoint (this);
+        outpipes.push_back (outpipe_);
+    }
     xattach_pipes (inpipe_, outpipe_, peer_identity_);
+    notify_poller ();
 }
 
 void zmq::socket_base_t::detach_inpipe (class reader_t *pipe_)
 {
     xdetach_inpipe (pipe_);
     pipe_->set_endpoint (NULL); // ?
+    notify_poller ();
 }
 
 void zmq::socket_base_t::detach_outpipe (class writer_t *pipe_)
 {
     xdetach_outpipe (pipe_);
     pipe_->set_endpoint (NULL); // ?
+    outpipes_t::iterator it = std::find (outpipes.begin (), outpipes.end (),
+        pipe_);
+    zmq_assert (it != outpipes.end ());
+    outpipes.erase (it);
+    notify_poller ();
 }
 
 void zmq::socket_base_t::process_own (owned_t *object_)
@@ -39,6 +39,11 @@
 namespace zmq
 {
 
+    //  Send flag used internally by batch sending. The message is written
+    //  to the pipe, but the pipe is not flushed. Once the whole batch is
+    //  written, the socket flushes its pipes in xflush.
+    enum { send_noflush = 0x10000 };
+
     class socket_base_t :
         public object_t, public i_endpoint, public yarray_item_t
     {
@@ -49,10 +54,13 @@ namespace zmq
         //  Interface for communication with the API layer.
         int setsockopt (int option_, const void *optval_,
             size_t optvallen_);
+        int getsockopt (int option_, void *optval_, size_t *optvallen_);
         int bind (const char *addr_);
         int connect (const char *addr_);
         int send (zmq_msg_t *msg_, int flags_);
         int recv (zmq_msg_t *msg_, int flags_);
+        int sendv (zmq_msg_t *msgs_, size_t count_, int flags_);
+        int recvv (zmq_msg_t *msgs_, size_t count_, int flags_);
         int close ();
 
         //  When another owned object wants to send command to this object
@@ -60,6 +68,10 @@ namespace zmq
         //  before the command is delivered.
         void inc_seqnum ();
 
+        //  Called by the connecters owned by the socket each time they
+        //  attempt to reconnect. It's invoked from the I/O threads.
+        void inc_reconnects ();
+
         //  This function is used by the polling mechanism to determine
         //  whether the socket belongs to the application thread the poll
         //  is called from.
@@ -70,6 +82,13 @@ namespace zmq
         bool has_in ();
         bool has_out ();
 
+        //  Associates the socket with a persistent poller. The poller is
+        //  notified each time the state of the socket changes in a way that
+        //  may affect the events reported. item_ is passed back to the poller
+        //  in the notification.
+        void set_poller (class socket_poller_t *poller_, void *item_);
+        class socket_poller_t *get_poller ();
+
         //  The list of sessions cannot be accessed via inter-thread
         //  commands as it is unacceptable to wait for the completion of the
         //  action till user application yields control of the application
@@ -113,14 +132,23 @@ namespace zmq
             size_t optvallen_) = 0;
         virtual int xsend (zmq_msg_t *msg_, int options_) = 0;
         virtual int xrecv (zmq_msg_t *msg_, int options_) = 0;
+        virtual void xflush () = 0;
         virtual bool xhas_in () = 0;
         virtual bool xhas_out () = 0;
 
         //  Socket options.
         options_t options;
 
+        //  Number of messages dropped by the socket type, e.g. because
+        //  the peer was over its high water mark.
+        uint64_t drops;
+
     private:
 
+        //  Lets the poller, if any, know that the socket should be checked
+        //  for events.
+        void notify_poller ();
+
         //  Handlers for incoming commands.
         void process_own (class owned_t *object_);
         void process_bind (class reader_t *in_pipe_, class writer_t *out_pipe_,
@@ -139,11 +167,34 @@ namespace zmq
         int pending_term_acks;
 
         //  Number of messages received since last command processing.
-        int ticks;
+        uint64_t ticks;
+
+        //  Statistics reported by getsockopt. They are updated by the
+        //  application thread only, so no synchronisation is needed.
+        uint64_t msgs_sent;
+        uint64_t msgs_received;
+        uint64_t bytes_sent;
+        uint64_t bytes_received;
+
+        //  Number of send calls that found the peers over their high water
+        //  marks.
+        uint64_t hwm_stalls;
+
+        //  Number of reconnection attempts. Updated from the I/O threads.
+        atomic_counter_t reconnects;
+
+        //  Outbound pipes attached to the socket. Used to compute the number
+        //  of messages queued for the peers.
+        typedef std::vector <class writer_t*> outpipes_t;
+        outpipes_t outpipes;
 
         //  Application thread the socket lives in.
         class app_thread_t *app_thread;
 
+        //  Persistent poller the socket is registered with, if any.
+        class socket_poller_t *poller;
+        void *poller_item;
+
         //  If true, socket is already shutting down. No new work should be
         //  started.
         bool shutting_down;
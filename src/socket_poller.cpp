@@ -0,0 +1,414 @@
+/*
+    Copyright (c) 2007-2010 iMatix Corporation
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the Lesser GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    Lesser GNU General Public License for more details.
+
+    You should have received a copy of the Lesser GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "platform.hpp"
+
+#if defined ZMQ_HAVE_LINUX || defined ZMQ_HAVE_FREEBSD ||\
+    defined ZMQ_HAVE_OPENBSD || defined ZMQ_HAVE_SOLARIS ||\
+    defined ZMQ_HAVE_OSX || defined ZMQ_HAVE_QNXNTO ||\
+    defined ZMQ_HAVE_HPUX || defined ZMQ_HAVE_AIX ||\
+    defined ZMQ_HAVE_NETBSD
+
+#include <new>
+#include <algorithm>
+#include <unistd.h>
+
+#include "socket_poller.hpp"
+#include "socket_base.hpp"
+#include "app_thread.hpp"
+#include "i_signaler.hpp"
+#include "config.hpp"
+#include "err.hpp"
+
+zmq::socket_poller_t::socket_poller_t () :
+    app_thread (NULL)
+{
+    signaler.item.socket = NULL;
+    signaler.item.fd = retired_fd;
+    signaler.item.events = ZMQ_POLLIN;
+    signaler.pending = false;
+
+#if defined ZMQ_HAVE_LINUX
+    epoll_fd = epoll_create (1);
+    errno_assert (epoll_fd != -1);
+#endif
+}
+
+zmq::socket_poller_t::~socket_poller_t ()
+{
+    for (sockets_t::iterator it = sockets.begin (); it != sockets.end ();
+          it++) {
+        it->first->set_poller (NULL, NULL);
+        delete it->second;
+    }
+    for (fds_t::iterator it = fds.begin (); it != fds.end (); it++)
+        delete it->second;
+
+#if defined ZMQ_HAVE_LINUX
+    close (epoll_fd);
+#endif
+}
+
+int zmq::socket_poller_t::add (zmq_pollitem_t *item_)
+{
+    if (item_->socket) {
+        socket_base_t *s = (socket_base_t*) item_->socket;
+
+        //  The socket may be registered only with a single poller.
+        if (s->get_poller ()) {
+            errno = EINVAL;
+            return -1;
+        }
+
+        //  All the sockets have to belong to the same application thread.
+        //  Once the first socket is added, start polling for the commands
+        //  sent to the thread. If ZMQ_POLL was not set, fail.
+        if (app_thread && app_thread != s->get_thread ()) {
+            errno = EFAULT;
+            return -1;
+        }
+        if (!app_thread) {
+            fd_t fd = s->get_thread ()->get_signaler ()->get_fd ();
+            if (fd == retired_fd) {
+                errno = ENOTSUP;
+                return -1;
+            }
+            app_thread = s->get_thread ();
+            signaler.item.fd = fd;
+            add_fd (&signaler);
+        }
+
+        item_t *item = new (std::nothrow) item_t;
+        zmq_assert (item);
+        item->item = *item_;
+        item->item.revents = 0;
+        item->pending = false;
+        sockets.insert (sockets_t::value_type (s, item));
+        s->set_poller (this, item);
+
+        //  Check the socket during the next wait.
+        mark (item);
+        return 0;
+    }
+
+    if (fds.find (item_->fd) != fds.end ()) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    item_t *item = new (std::nothrow) item_t;
+    zmq_assert (item);
+    item->item = *item_;
+    item->item.revents = 0;
+    item->pending = false;
+    fds.insert (fds_t::value_type (item_->fd, item));
+    add_fd (item);
+    return 0;
+}
+
+int zmq::socket_poller_t::modify (zmq_pollitem_t *item_)
+{
+    if (item_->socket) {
+        sockets_t::iterator it =
+            sockets.find ((socket_base_t*) item_->socket);
+        if (it == sockets.end ()) {
+            errno = EINVAL;
+            return -1;
+        }
+        it->second->item.events = item_->events;
+        mark (it->second);
+        return 0;
+    }
+
+    fds_t::iterator it = fds.find (item_->fd);
+    if (it == fds.end ()) {
+        errno = EINVAL;
+        return -1;
+    }
+    it->second->item.events = item_->events;
+    modify_fd (it->second);
+    return 0;
+}
+
+int zmq::socket_poller_t::remove (zmq_pollitem_t *item_)
+{
+    if (item_->socket) {
+        socket_base_t *s = (socket_base_t*) item_->socket;
+        sockets_t::iterator it = sockets.find (s);
+        if (it == sockets.end ()) {
+            errno = EINVAL;
+            return -1;
+        }
+        item_t *item = it->second;
+        if (item->pending)
+            pending.erase (std::find (pending.begin (), pending.end (), item));
+        sockets.erase (it);
+        s->set_poller (NULL, NULL);
+        delete item;
+
+        //  If there are no more sockets, there's no need to poll for
+        //  the commands.
+        if (sockets.empty ()) {
+            rm_fd (&signaler);
+            signaler.item.fd = retired_fd;
+            app_thread = NULL;
+        }
+        return 0;
+    }
+
+    fds_t::iterator it = fds.find (item_->fd);
+    if (it == fds.end ()) {
+        errno = EINVAL;
+        return -1;
+    }
+    rm_fd (it->second);
+    delete it->second;
+    fds.erase (it);
+    return 0;
+}
+
+int zmq::socket_poller_t::wait (zmq_pollitem_t *items_, int nitems_,
+    long timeout_)
+{
+    //  If some of the sockets already have events to report, return them
+    //  straight away without touching the file descriptors.
+    int nevents = check_pending (items_, nitems_, 0);
+    if (nevents)
+        return nevents;
+
+    int timeout = timeout_ > 0 ? timeout_ / 1000 : (timeout_ ? -1 : 0);
+    while (true) {
+
+        //  Process 0MQ commands if needed. This marks the affected sockets.
+        bool signaled = false;
+        nevents = poll_fds (timeout, items_, nitems_, &signaled);
+        if (signaled) {
+            app_thread->process_signaled_commands ();
+            nevents = check_pending (items_, nitems_, nevents);
+        }
+
+        //  Commands that haven't resulted in any events don't count as
+        //  events, however, the wait is restarted only if there's no
+        //  timeout to obey.
+        if (nevents || !signaled || timeout >= 0)
+            return nevents;
+    }
+}
+
+int zmq::socket_poller_t::check_pending (zmq_pollitem_t *items_, int nitems_,
+    int nevents_)
+{
+    //  Sockets with no events are dropped from the list till they are marked
+    //  anew.
+    pending_t::size_type pos = 0;
+    while (pos != pending.size ()) {
+        item_t *item = pending [pos];
+        if (!check_socket (item)) {
+            item->pending = false;
+            pending [pos] = pending.back ();
+            pending.pop_back ();
+            continue;
+        }
+        if (nevents_ != nitems_)
+            items_ [nevents_++] = item->item;
+        pos++;
+    }
+    return nevents_;
+}
+
+void zmq::socket_poller_t::mark (void *item_)
+{
+    item_t *item = (item_t*) item_;
+    if (!item->pending) {
+        item->pending = true;
+        pending.push_back (item);
+    }
+}
+
+void zmq::socket_poller_t::remove_socket (socket_base_t *socket_)
+{
+    zmq_pollitem_t item;
+    item.socket = socket_;
+    item.fd = retired_fd;
+    item.events = 0;
+    int rc = remove (&item);
+    zmq_assert (rc == 0);
+}
+
+bool zmq::socket_poller_t::check_socket (item_t *item_)
+{
+    socket_base_t *s = (socket_base_t*) item_->item.socket;
+    item_->item.revents = 0;
+    if ((item_->item.events & ZMQ_POLLOUT) && s->has_out ())
+        item_->item.revents |= ZMQ_POLLOUT;
+    if ((item_->item.events & ZMQ_POLLIN) && s->has_in ())
+        item_->item.revents |= ZMQ_POLLIN;
+    return item_->item.revents != 0;
+}
+
+#if defined ZMQ_HAVE_LINUX
+
+void zmq::socket_poller_t::add_fd (item_t *item_)
+{
+    epoll_event ev;
+    ev.events =
+        (item_->item.events & ZMQ_POLLIN ? (uint32_t) EPOLLIN : (uint32_t) 0) |
+        (item_->item.events & ZMQ_POLLOUT ? (uint32_t) EPOLLOUT : (uint32_t) 0);
+    ev.data.ptr = item_;
+    int rc = epoll_ctl (epoll_fd, EPOLL_CTL_ADD, item_->item.fd, &ev);
+    errno_assert (rc != -1);
+}
+
+void zmq::socket_poller_t::modify_fd (item_t *item_)
+{
+    epoll_event ev;
+    ev.events =
+        (item_->item.events & ZMQ_POLLIN ? (uint32_t) EPOLLIN : (uint32_t) 0) |
+        (item_->item.events & ZMQ_POLLOUT ? (uint32_t) EPOLLOUT : (uint32_t) 0);
+    ev.data.ptr = item_;
+    int rc = epoll_ctl (epoll_fd, EPOLL_CTL_MOD, item_->item.fd, &ev);
+    errno_assert (rc != -1);
+}
+
+void zmq::socket_poller_t::rm_fd (item_t *item_)
+{
+    //  The file descriptor may have been already closed by the user, in which
+    //  case it was removed from the epoll set automatically.
+    epoll_event ev;
+    int rc = epoll_ctl (epoll_fd, EPOLL_CTL_DEL, item_->item.fd, &ev);
+    errno_assert (rc != -1 || errno == EBADF || errno == ENOENT);
+}
+
+int zmq::socket_poller_t::poll_fds (int timeout_, zmq_pollitem_t *items_,
+    int nitems_, bool *signaled_)
+{
+    epoll_event ev_buf [max_io_events];
+
+    //  Wait for events. Ignore interrupts if there's infinite timeout.
+    int n;
+    while (true) {
+        n = epoll_wait (epoll_fd, &ev_buf [0], max_io_events, timeout_);
+        if (n == -1 && errno == EINTR) {
+            if (timeout_ < 0)
+                continue;
+            return 0;
+        }
+        errno_assert (n != -1);
+        break;
+    }
+
+    int nevents = 0;
+    for (int i = 0; i != n; i++) {
+        item_t *item = (item_t*) ev_buf [i].data.ptr;
+        if (item == &signaler) {
+            *signaled_ = true;
+            continue;
+        }
+        if (nevents == nitems_)
+            continue;
+        items_ [nevents] = item->item;
+        items_ [nevents].revents = 0;
+        if (ev_buf [i].events & EPOLLIN)
+            items_ [nevents].revents |= ZMQ_POLLIN;
+        if (ev_buf [i].events & EPOLLOUT)
+            items_ [nevents].revents |= ZMQ_POLLOUT;
+        if (ev_buf [i].events & ~(EPOLLIN | EPOLLOUT))
+            items_ [nevents].revents |= ZMQ_POLLERR;
+        nevents++;
+    }
+    return nevents;
+}
+
+#else
+
+void zmq::socket_poller_t::add_fd (item_t *item_)
+{
+    pollfd pfd;
+    pfd.fd = item_->item.fd;
+    pfd.events = (item_->item.events & ZMQ_POLLIN ? POLLIN : 0) |
+        (item_->item.events & ZMQ_POLLOUT ? POLLOUT : 0);
+    pfd.revents = 0;
+    item_->index = (int) pollset.size ();
+    pollset.push_back (pfd);
+    pollitems.push_back (item_);
+}
+
+void zmq::socket_poller_t::modify_fd (item_t *item_)
+{
+    pollset [item_->index].events =
+        (item_->item.events & ZMQ_POLLIN ? POLLIN : 0) |
+        (item_->item.events & ZMQ_POLLOUT ? POLLOUT : 0);
+}
+
+void zmq::socket_poller_t::rm_fd (item_t *item_)
+{
+    //  Move the last file descriptor to the place of the removed one.
+    int index = item_->index;
+    pollset [index] = pollset.back ();
+    pollitems [index] = pollitems.back ();
+    pollitems [index]->index = index;
+    pollset.pop_back ();
+    pollitems.pop_back ();
+}
+
+int zmq::socket_poller_t::poll_fds (int timeout_, zmq_pollitem_t *items_,
+    int nitems_, bool *signaled_)
+{
+    //  Wait for events. Ignore interrupts if there's infinite timeout.
+    int rc;
+    while (true) {
+        rc = poll (pollset.empty () ? NULL : &pollset [0], pollset.size (),
+            timeout_);
+        if (rc == -1 && errno == EINTR) {
+            if (timeout_ < 0)
+                continue;
+            return 0;
+        }
+        errno_assert (rc != -1);
+        break;
+    }
+
+    int nevents = 0;
+    for (pollset_t::size_type i = 0; rc && i != pollset.size (); i++) {
+        if (!pollset [i].revents)
+            continue;
+        rc--;
+        item_t *item = pollitems [i];
+        if (item == &signaler) {
+            *signaled_ = true;
+            continue;
+        }
+        if (nevents == nitems_)
+            continue;
+        items_ [nevents] = item->item;
+        items_ [nevents].revents = 0;
+        if (pollset [i].revents & POLLIN)
+            items_ [nevents].revents |= ZMQ_POLLIN;
+        if (pollset [i].revents & POLLOUT)
+            items_ [nevents].revents |= ZMQ_POLLOUT;
+        if (pollset [i].revents & ~(POLLIN | POLLOUT))
+            items_ [nevents].revents |= ZMQ_POLLERR;
+        nevents++;
+    }
+    return nevents;
+}
+
+#endif
+
+#endif
@@ -0,0 +1,159 @@
+/*
+    Copyright (c) 2007-2010 iMatix Corporation
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the Lesser GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    Lesser GNU General Public License for more details.
+
+    You should have received a copy of the Lesser GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_SOCKET_POLLER_HPP_INCLUDED__
+#define __ZMQ_SOCKET_POLLER_HPP_INCLUDED__
+
+#include <map>
+#include <vector>
+
+#include "../include/zmq.h"
+
+#include "platform.hpp"
+
+#if defined ZMQ_HAVE_LINUX || defined ZMQ_HAVE_FREEBSD ||\
+    defined ZMQ_HAVE_OPENBSD || defined ZMQ_HAVE_SOLARIS ||\
+    defined ZMQ_HAVE_OSX || defined ZMQ_HAVE_QNXNTO ||\
+    defined ZMQ_HAVE_HPUX || defined ZMQ_HAVE_AIX ||\
+    defined ZMQ_HAVE_NETBSD
+
+#if defined ZMQ_HAVE_LINUX
+#include <sys/epoll.h>
+#else
+#include <poll.h>
+#endif
+
+#include "fd.hpp"
+
+namespace zmq
+{
+
+    //  Persistent set of 0MQ sockets and file descriptors to poll on. Unlike
+    //  zmq_poll, the set is not rebuilt on each invocation. File descriptors
+    //  are kept registered with the OS-level polling mechanism (epoll on
+    //  Linux) and 0MQ sockets notify the poller whenever their state changes
+    //  in a way that may affect the events reported. Thus, only sockets that
+    //  are possibly ready are checked when waiting for events.
+    //
+    //  The poller is not thread-safe. It must be used from the application
+    //  thread the sockets registered with it belong to. A socket can be
+    //  registered with a single poller at a time.
+
+    class socket_poller_t
+    {
+    public:
+
+        socket_poller_t ();
+        ~socket_poller_t ();
+
+        //  Registers, modifies or unregisters a socket or file descriptor.
+        //  'socket' or 'fd' member of the item identifies the socket
+        //  (the same way as in zmq_poll) and 'events' specifies the events
+        //  to poll for.
+        int add (zmq_pollitem_t *item_);
+        int modify (zmq_pollitem_t *item_);
+        int remove (zmq_pollitem_t *item_);
+
+        //  Waits for events for up to timeout_ microseconds. Items with
+        //  events signaled are stored in items_ array, at most nitems_ of
+        //  them. Returns number of items stored.
+        int wait (zmq_pollitem_t *items_, int nitems_, long timeout_);
+
+        //  Called by the socket when its state have changed. 'item_' is
+        //  the value passed by the poller to socket_base_t::set_poller.
+        void mark (void *item_);
+
+        //  Called by the socket when it is being closed.
+        void remove_socket (class socket_base_t *socket_);
+
+    private:
+
+        struct item_t
+        {
+            //  Socket or file descriptor and the events to poll for.
+            zmq_pollitem_t item;
+
+            //  True if the socket is in the list of pending sockets.
+            bool pending;
+
+#if !defined ZMQ_HAVE_LINUX
+            //  Position of the file descriptor in the pollset.
+            int index;
+#endif
+        };
+
+        //  Returns true if the item should be reported. Fills in revents.
+        bool check_socket (item_t *item_);
+
+        //  Checks the sockets that may have events to report. Items with
+        //  events are appended to items_, which already holds nevents_
+        //  items. Returns the new number of items.
+        int check_pending (zmq_pollitem_t *items_, int nitems_, int nevents_);
+
+        //  Registers the file descriptor with the polling mechanism,
+        //  modifies the events polled for or unregisters it.
+        void add_fd (item_t *item_);
+        void modify_fd (item_t *item_);
+        void rm_fd (item_t *item_);
+
+        //  Polls the registered file descriptors. Items for file descriptors
+        //  with events are stored to items_ and their number is returned.
+        //  If there are commands for the application thread, 'signaled_' is
+        //  set to true.
+        int poll_fds (int timeout_, zmq_pollitem_t *items_, int nitems_,
+            bool *signaled_);
+
+        //  Application thread all the sockets belong to.
+        class app_thread_t *app_thread;
+
+        //  Item for the file descriptor used to signal commands to
+        //  the application thread.
+        item_t signaler;
+
+        //  Registered 0MQ sockets.
+        typedef std::map <class socket_base_t*, item_t*> sockets_t;
+        sockets_t sockets;
+
+        //  Registered file descriptors.
+        typedef std::map <fd_t, item_t*> fds_t;
+        fds_t fds;
+
+        //  Sockets that may have events to report.
+        typedef std::vector <item_t*> pending_t;
+        pending_t pending;
+
+#if defined ZMQ_HAVE_LINUX
+        fd_t epoll_fd;
+#else
+        //  Set of file descriptors to poll on. Corresponding items are
+        //  stored in 'pollitems'.
+        typedef std::vector <pollfd> pollset_t;
+        pollset_t pollset;
+        std::vector <item_t*> pollitems;
+#endif
+
+        socket_poller_t (const socket_poller_t&);
+        void operator = (const socket_poller_t&);
+    };
+
+}
+
+#endif
+
+#endif
@@ -22,6 +22,8 @@
 #include "../include/zmq.h"
 
 #include "sub.hpp"
+#include "subscription.hpp"
+#include "pipe.hpp"
 #include "err.hpp"
 
 zmq::sub_t::sub_t (class app_thread_t *parent_) :
@@ -31,19 +33,38 @@ zmq::sub_t::sub_t (class app_thread_t *parent_) :
 {
     options.requires_in = true;
     options.requires_out = false;
+    options.requires_subscriptions = true;
     zmq_msg_init (&message);
 }
 
 zmq::sub_t::~sub_t ()
 {
+    for (out_pipes_t::size_type i = 0; i != out_pipes.size (); i++)
+        out_pipes [i]->term ();
+    out_pipes.clear ();
+
     zmq_msg_close (&message);
 }
 
 void zmq::sub_t::xattach_pipes (class reader_t *inpipe_,
     class writer_t *outpipe_, const blob_t &peer_identity_)
 {
-    zmq_assert (inpipe_ && !outpipe_);
+    zmq_assert (inpipe_);
     fq.attach (inpipe_);
+
+    //  Outbound pipe is missing if the transport can't forward subscriptions.
+    //  Otherwise, let the publisher know about all the subscriptions.
+    if (outpipe_) {
+        out_pipes.push_back (outpipe_);
+        for (prefixes_t::iterator it = prefixes.begin ();
+              it != prefixes.end (); it++)
+            send_command (outpipe_, subscribe_command, it->data (),
+                it->size ());
+        for (prefixes_t::iterator it = exact_topics.begin ();
+              it != exact_topics.end (); it++)
+            send_command (outpipe_, subscribe_exact_command, it->data (),
+                it->size ());
+    }
 }
 
 void zmq::sub_t::xdetach_inpipe (class reader_t *pipe_)
@@ -54,8 +75,7 @@ void zmq::sub_t::xdetach_inpipe (class reader_t *pipe_)
 
 void zmq::sub_t::xdetach_outpipe (class writer_t *pipe_)
 {
-    //  SUB socket is read-only thus there should be no outpipes.
-    zmq_assert (false);
+    out_pipes.erase (pipe_);
 }
 
 void zmq::sub_t::xkill (class reader_t *pipe_)
@@ -70,6 +90,8 @@ void zmq::sub_t::xrevive (class reader_t *pipe_)
 
 void zmq::sub_t::xrevive (class writer_t *pipe_)
 {
+    //  Pipes carrying subscriptions have no limits, thus they never have
+    //  to be revived.
     zmq_assert (false);
 }
 
@@ -78,6 +100,10 @@ int zmq::sub_t::xsetsockopt (int option_, const void *optval_,
 {
     if (option_ == ZMQ_SUBSCRIBE) {
         subscriptions.add ((unsigned char*) optval_, optvallen_);
+        prefixes.insert (blob_t ((unsigned char*) optval_, optvallen_));
+        for (out_pipes_t::size_type i = 0; i != out_pipes.size (); i++)
+            send_command (out_pipes [i], subscribe_command,
+                (unsigned char*) optval_, optvallen_);
         return 0;
     }
     
@@ -86,9 +112,42 @@ int zmq::sub_t::xsetsockopt (int option_, const void *optval_,
             errno = EINVAL;
             return -1;
         }
+        prefixes.erase (prefixes.find (
+            blob_t ((unsigned char*) optval_, optvallen_)));
+        for (out_pipes_t::size_type i = 0; i != out_pipes.size (); i++)
+            send_command (out_pipes [i], unsubscribe_command,
+                (unsigned char*) optval_, optvallen_);
+        return 0;
+    }
+
+    if (option_ == ZMQ_SUBSCRIBE_EXACT) {
+        if (!exact_subscriptions.add ((unsigned char*) optval_, optvallen_)) {
+            errno = EINVAL;
+            return -1;
+        }
+        exact_topics.insert (blob_t ((unsigned char*) optval_, optvallen_));
+        for (out_pipes_t::size_type i = 0; i != out_pipes.size (); i++)
+            send_command (out_pipes [i], subscribe_exact_command,
+                (unsigned char*) optval_, optvallen_);
+        return 0;
+    }
+
+    if (option_ == ZMQ_UNSUBSCRIBE_EXACT) {
+        if (!exact_subscriptions.rm ((unsigned char*) optval_, optvallen_)) {
+            errno = EINVAL;
+            return -1;
+        }
+        exact_topics.erase (exact_topics.find (
+            blob_t ((unsigned char*) optval_, optvallen_)));
+        for (out_pipes_t::size_type i = 0; i != out_pipes.size (); i++)
+            send_command (out_pipes [i], unsubscribe_exact_command,
+                (unsigned char*) optval_, optvallen_);
         return 0;
     }
 
+    if (option_ == ZMQ_QUANTUM)
+        return fq.set_quantum (optval_, optvallen_);
+
     errno = EINVAL;
     return -1;
 }
@@ -139,6 +198,12 @@ int zmq::sub_t::xrecv (zmq_msg_t *msg_, int flags_)
     }
 }
 
+void zmq::sub_t::xflush ()
+{
+    //  Subscriptions are flushed as soon as they are sent. There are no
+    //  messages to flush.
+}
+
 bool zmq::sub_t::xhas_in ()
 {
     //  There are subsequent parts of the partly-read message available.
@@ -186,6 +251,26 @@ bool zmq::sub_t::xhas_out ()
 
 bool zmq::sub_t::match (zmq_msg_t *msg_)
 {
-    return subscriptions.check ((unsigned char*) zmq_msg_data (msg_),
-        zmq_msg_size (msg_));
+    //  Exact-match subscriptions take a single hash lookup. The prefix tree
+    //  is walked only if there are any prefix subscriptions.
+    unsigned char *data = (unsigned char*) zmq_msg_data (msg_);
+    size_t size = zmq_msg_size (msg_);
+    if (exact_subscriptions.check (data, size))
+        return true;
+    return !subscriptions.empty () && subscriptions.check (data, size);
+}
+
+void zmq::sub_t::send_command (writer_t *pipe_, unsigned char command_,
+    const unsigned char *prefix_, size_t size_)
+{
+    zmq_msg_t msg;
+    int rc = zmq_msg_init_size (&msg, size_ + 1);
+    zmq_assert (rc == 0);
+    unsigned char *data = (unsigned char*) zmq_msg_data (&msg);
+    data [0] = command_;
+    if (size_)
+        memcpy (data + 1, prefix_, size_);
+    bool written = pipe_->write (&msg);
+    zmq_assert (written);
+    pipe_->flush ();
 }
@@ -20,10 +20,15 @@
 #ifndef __ZMQ_SUB_HPP_INCLUDED__
 #define __ZMQ_SUB_HPP_INCLUDED__
 
+#include <set>
+
 #include "../include/zmq.h"
 
 #include "prefix_tree.hpp"
+#include "topic_hash.hpp"
 #include "socket_base.hpp"
+#include "yarray.hpp"
+#include "blob.hpp"
 #include "fq.hpp"
 
 namespace zmq
@@ -49,20 +54,39 @@ namespace zmq
         int xsetsockopt (int option_, const void *optval_, size_t optvallen_);
         int xsend (zmq_msg_t *msg_, int flags_);
         int xrecv (zmq_msg_t *msg_, int flags_);
+        void xflush ();
         bool xhas_in ();
         bool xhas_out ();
 
     private:
 
         //  Check whether the message matches at least one subscription.
+        //  Most non-matching messages are dropped by the session already,
+        //  this catches those queued before the subscriptions changed.
         bool match (zmq_msg_t *msg_);
 
+        //  Sends subscription command to the publisher via the pipe.
+        void send_command (class writer_t *pipe_, unsigned char command_,
+            const unsigned char *prefix_, size_t size_);
+
         //  Fair queueing object for inbound pipes.
         fq_t fq;
 
         //  The repository of subscriptions.
         prefix_tree_t subscriptions;
 
+        //  The repository of exact-match subscriptions.
+        topic_hash_t exact_subscriptions;
+
+        //  List of the subscriptions to send to newly attached publishers.
+        typedef std::multiset <blob_t> prefixes_t;
+        prefixes_t prefixes;
+        prefixes_t exact_topics;
+
+        //  Outbound pipes, i.e. those the subscriptions are forwarded to.
+        typedef yarray_t <class writer_t> out_pipes_t;
+        out_pipes_t out_pipes;
+
         //  If true, 'message' contains a matching message to return on the
         //  next recv call.
         bool has_message;
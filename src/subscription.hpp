@@ -0,0 +1,47 @@
+/*
+    Copyright (c) 2007-2010 iMatix Corporation
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the Lesser GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    Lesser GNU General Public License for more details.
+
+    You should have received a copy of the Lesser GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_SUBSCRIPTION_HPP_INCLUDED__
+#define __ZMQ_SUBSCRIPTION_HPP_INCLUDED__
+
+namespace zmq
+{
+
+    //  Subscriptions are forwarded from SUB sockets to PUB sockets, i.e. in
+    //  the direction opposite to the messages. Each subscription command is
+    //  a single-part message. The first byte of the message is the command
+    //  type, the rest of it is the prefix the command applies to.
+    enum
+    {
+        unsubscribe_command = 0,
+        subscribe_command = 1,
+
+        //  Drops all the subscriptions received so far. Sent before
+        //  the subscriptions are re-sent on reconnection.
+        reset_subscriptions_command = 2,
+
+        //  Exact-match subscriptions. All of them have the same size and
+        //  match messages beginning with exactly the specified topic.
+        unsubscribe_exact_command = 3,
+        subscribe_exact_command = 4
+    };
+
+}
+
+#endif
@@ -0,0 +1,328 @@
+/*
+    Copyright (c) 2007-2010 iMatix Corporation
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the Lesser GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    Lesser GNU General Public License for more details.
+
+    You should have received a copy of the Lesser GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "platform.hpp"
+
+#if defined ZMQ_HAVE_WINDOWS
+#include "windows.hpp"
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#endif
+
+#include "swap.hpp"
+#include "atomic_counter.hpp"
+#include "config.hpp"
+#include "wire.hpp"
+#include "err.hpp"
+
+//  Each message is stored as 8-byte size, 1-byte flags and the message body.
+enum {header_size = 9};
+
+//  Sequence number used to generate unique swap file names.
+static zmq::atomic_counter_t swap_seqnum;
+
+zmq::swap_t::swap_t (int64_t filesize_) :
+    filesize (filesize_),
+    capacity (filesize_),
+    allocated (0),
+    read_pos (0),
+    write_pos (0),
+    commit_pos (0)
+{
+    zmq_assert (filesize_ > 0);
+
+    write_window.data = NULL;
+    write_window.offset = 0;
+    read_window.data = NULL;
+    read_window.offset = 0;
+
+#if defined ZMQ_HAVE_WINDOWS
+    fd = INVALID_HANDLE_VALUE;
+#else
+    fd = -1;
+#endif
+}
+
+int zmq::swap_t::init ()
+{
+    //  Swap file is created in the current working directory. Its name is
+    //  composed of the process ID and a sequence number to be unique.
+    char filename [64];
+#if defined ZMQ_HAVE_WINDOWS
+    sprintf (filename, "zmq_%lu_%u.swap", (unsigned long) GetCurrentProcessId (),
+        (unsigned int) swap_seqnum.add (1));
+#else
+    sprintf (filename, "zmq_%lu_%u.swap", (unsigned long) getpid (),
+        (unsigned int) swap_seqnum.add (1));
+#endif
+
+#if defined ZMQ_HAVE_WINDOWS
+    //  The file is deleted automatically when the handle is closed.
+    fd = CreateFileA (filename, GENERIC_READ | GENERIC_WRITE, 0, NULL,
+        CREATE_NEW, FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE,
+        NULL);
+    if (fd == INVALID_HANDLE_VALUE) {
+        errno = EACCES;
+        return -1;
+    }
+#else
+    fd = open (filename, O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+    if (fd == -1)
+        return -1;
+
+    //  Remove the file from the directory straight away so that it doesn't
+    //  linger there even if the process crashes.
+    int rc = unlink (filename);
+    if (rc != 0) {
+        int err = errno;
+        rc = close (fd);
+        errno_assert (rc == 0);
+        fd = -1;
+        errno = err;
+        return -1;
+    }
+#endif
+    return 0;
+}
+
+zmq::swap_t::~swap_t ()
+{
+    unmap (write_window);
+    unmap (read_window);
+
+#if defined ZMQ_HAVE_WINDOWS
+    if (fd != INVALID_HANDLE_VALUE) {
+        BOOL brc = CloseHandle (fd);
+        win_assert (brc);
+    }
+#else
+    if (fd != -1) {
+        int rc = close (fd);
+        errno_assert (rc == 0);
+    }
+#endif
+}
+
+bool zmq::swap_t::fits (size_t size_)
+{
+    //  If part of a message was already stored, the rest of it has to be
+    //  accepted to keep the message atomic.
+    if (write_pos != commit_pos)
+        return true;
+
+    return write_pos - read_pos + header_size + size_ <= filesize;
+}
+
+void zmq::swap_t::store (zmq_msg_t *msg_)
+{
+    size_t size = zmq_msg_size (msg_);
+
+    //  Only the remaining parts of a multi-part message may not fit.
+    if (write_pos - read_pos + header_size + size > capacity) {
+        zmq_assert (write_pos != commit_pos);
+        grow (header_size + size);
+    }
+
+    unsigned char header [header_size];
+    put_uint64 (header, size);
+    header [8] = msg_->flags & ZMQ_MSG_MORE;
+    copy_to_file (write_pos, header, header_size);
+    copy_to_file (write_pos + header_size, zmq_msg_data (msg_), size);
+    write_pos += header_size + size;
+}
+
+void zmq::swap_t::commit ()
+{
+    commit_pos = write_pos;
+}
+
+void zmq::swap_t::rollback ()
+{
+    write_pos = commit_pos;
+}
+
+bool zmq::swap_t::check_fetch ()
+{
+    return read_pos != commit_pos;
+}
+
+void zmq::swap_t::fetch (zmq_msg_t *msg_)
+{
+    zmq_assert (check_fetch ());
+
+    unsigned char header [header_size];
+    copy_from_file (read_pos, header, header_size);
+    size_t size = (size_t) get_uint64 (header);
+
+    int rc = zmq_msg_init_size (msg_, size);
+    errno_assert (rc == 0);
+    copy_from_file (read_pos + header_size, zmq_msg_data (msg_), size);
+    msg_->flags = header [8];
+    read_pos += header_size + size;
+
+    //  If the swap is drained, rewind to the beginning of the file so that
+    //  the data are kept in as few windows as possible.
+    if (read_pos == write_pos) {
+        read_pos = 0;
+        write_pos = 0;
+        commit_pos = 0;
+        capacity = filesize;
+    }
+}
+
+bool zmq::swap_t::empty ()
+{
+    return read_pos == write_pos;
+}
+
+unsigned char *zmq::swap_t::map (window_t &window_, uint64_t pos_,
+    size_t *size_)
+{
+    uint64_t offset = pos_ - pos_ % swap_window_size;
+
+    if (!window_.data || window_.offset != offset) {
+        unmap (window_);
+
+        //  The file grows in whole windows. Note that the space is allocated
+        //  on the disk only once the data are actually written.
+        uint64_t end = offset + swap_window_size;
+        if (end > allocated) {
+#if defined ZMQ_HAVE_WINDOWS
+            LARGE_INTEGER distance;
+            distance.QuadPart = end;
+            BOOL brc = SetFilePointerEx (fd, distance, NULL, FILE_BEGIN);
+            win_assert (brc);
+            brc = SetEndOfFile (fd);
+            win_assert (brc);
+#else
+            int rc = ftruncate (fd, (off_t) end);
+            errno_assert (rc == 0);
+#endif
+            allocated = end;
+        }
+
+#if defined ZMQ_HAVE_WINDOWS
+        HANDLE mapping = CreateFileMapping (fd, NULL, PAGE_READWRITE,
+            (DWORD) (end >> 32), (DWORD) end, NULL);
+        win_assert (mapping != NULL);
+        window_.data = (unsigned char*) MapViewOfFile (mapping,
+            FILE_MAP_WRITE, (DWORD) (offset >> 32), (DWORD) offset,
+            swap_window_size);
+        win_assert (window_.data);
+        BOOL brc = CloseHandle (mapping);
+        win_assert (brc);
+#else
+        void *data = mmap (NULL, swap_window_size, PROT_READ | PROT_WRITE,
+            MAP_SHARED, fd, (off_t) offset);
+        errno_assert (data != MAP_FAILED);
+        window_.data = (unsigned char*) data;
+#endif
+        window_.offset = offset;
+    }
+
+    *size_ = (size_t) (offset + swap_window_size - pos_);
+    return window_.data + (pos_ - offset);
+}
+
+void zmq::swap_t::unmap (window_t &window_)
+{
+    if (!window_.data)
+        return;
+
+#if defined ZMQ_HAVE_WINDOWS
+    BOOL brc = UnmapViewOfFile (window_.data);
+    win_assert (brc);
+#else
+    int rc = munmap (window_.data, swap_window_size);
+    errno_assert (rc == 0);
+#endif
+    window_.data = NULL;
+}
+
+void zmq::swap_t::copy_to_file (uint64_t pos_, const void *data_,
+    size_t size_)
+{
+    const unsigned char *data = (const unsigned char*) data_;
+    while (size_) {
+        size_t available;
+        uint64_t offset = pos_ % capacity;
+        unsigned char *ptr = map (write_window, offset, &available);
+        if (available > capacity - offset)
+            available = (size_t) (capacity - offset);
+        size_t n = size_ < available ? size_ : available;
+        memcpy (ptr, data, n);
+        pos_ += n;
+        data += n;
+        size_ -= n;
+    }
+}
+
+void zmq::swap_t::copy_from_file (uint64_t pos_, void *data_, size_t size_)
+{
+    unsigned char *data = (unsigned char*) data_;
+    while (size_) {
+        size_t available;
+        uint64_t offset = pos_ % capacity;
+        unsigned char *ptr = map (read_window, offset, &available);
+        if (available > capacity - offset)
+            available = (size_t) (capacity - offset);
+        size_t n = size_ < available ? size_ : available;
+        memcpy (data, ptr, n);
+        pos_ += n;
+        data += n;
+        size_ -= n;
+    }
+}
+
+void zmq::swap_t::grow (uint64_t size_)
+{
+    uint64_t used = write_pos - read_pos;
+    uint64_t committed = commit_pos - read_pos;
+    uint64_t start = read_pos % capacity;
+    uint64_t old_capacity = capacity;
+
+    //  Rebase the logical positions to the positions within the file and
+    //  enlarge the ring.
+    read_pos = start;
+    write_pos = start + used;
+    commit_pos = start + committed;
+    capacity = write_pos + size_;
+
+    //  If the data wrapped around the end of the old ring, move the wrapped
+    //  part behind its end so that the data are contiguous. The source
+    //  lies at the beginning of the file, i.e. at the same logical position
+    //  in the new ring.
+    if (write_pos > old_capacity) {
+        unsigned char buf [4096];
+        uint64_t wrapped = write_pos - old_capacity;
+        for (uint64_t pos = 0; pos < wrapped; pos += sizeof (buf)) {
+            size_t n = (size_t) (wrapped - pos < sizeof (buf) ?
+                wrapped - pos : sizeof (buf));
+            copy_from_file (pos, buf, n);
+            copy_to_file (old_capacity + pos, buf, n);
+        }
+    }
+}
@@ -0,0 +1,151 @@
+/*
+    Copyright (c) 2007-2010 iMatix Corporation
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the Lesser GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    Lesser GNU General Public License for more details.
+
+    You should have received a copy of the Lesser GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_SWAP_HPP_INCLUDED__
+#define __ZMQ_SWAP_HPP_INCLUDED__
+
+#include <stddef.h>
+
+#include "../include/zmq.h"
+
+#include "platform.hpp"
+#include "stdint.hpp"
+
+#if defined ZMQ_HAVE_WINDOWS
+#include "windows.hpp"
+#endif
+
+namespace zmq
+{
+
+    //  Disk-backed overflow store for a message pipe. Messages are appended
+    //  to a swap file and read back in the same order. The file is accessed
+    //  via two memory-mapped windows, one for writing and one for reading,
+    //  so only a small portion of the file is mapped into memory at any time.
+    //
+    //  The file is used as a ring buffer, i.e. the space occupied by
+    //  the messages already read is reused straight away. Positions are
+    //  logical offsets that grow monotonically; the position within the file
+    //  is the logical offset modulo the capacity of the ring.
+    //
+    //  Swap is accessed exclusively from the thread owning the pipe writer.
+
+    class swap_t
+    {
+    public:
+
+        //  Create swap that may hold up to 'filesize_' bytes.
+        swap_t (int64_t filesize_);
+        ~swap_t ();
+
+        //  Creates the swap file. Returns -1 and sets errno if the file
+        //  cannot be created, e.g. if the working directory is read-only.
+        int init ();
+
+        //  Checks whether a message of the specified size can be stored in
+        //  the swap. The limit is checked only on message boundaries, so
+        //  the remaining parts of a multi-part message always fit.
+        bool fits (size_t size_);
+
+        //  Stores the message to the swap. The message is copied so caller
+        //  remains responsible for deallocating it. The caller should check
+        //  whether the message fits beforehand.
+        void store (zmq_msg_t *msg_);
+
+        //  Marks all the messages stored so far as complete, i.e. available
+        //  for fetching.
+        void commit ();
+
+        //  Removes the stored messages that were not committed yet.
+        void rollback ();
+
+        //  Returns true if there is a committed message to fetch.
+        bool check_fetch ();
+
+        //  Retrieves the oldest message from the swap. 'msg_' is expected
+        //  to be uninitialised.
+        void fetch (zmq_msg_t *msg_);
+
+        //  Returns true if there's no data in the swap, whether committed
+        //  or not.
+        bool empty ();
+
+    private:
+
+        //  Memory-mapped portion of the file.
+        struct window_t
+        {
+            unsigned char *data;
+            uint64_t offset;
+        };
+
+        //  Returns pointer to the position 'pos_' within the file and number
+        //  of bytes accessible from it. Maps the window to the appropriate
+        //  portion of the file if needed.
+        unsigned char *map (window_t &window_, uint64_t pos_, size_t *size_);
+
+        //  Releases the mapping of the window.
+        void unmap (window_t &window_);
+
+        //  Copy data to/from the file at the specified logical position.
+        void copy_to_file (uint64_t pos_, const void *data_, size_t size_);
+        void copy_from_file (uint64_t pos_, void *data_, size_t size_);
+
+        //  Enlarges the ring so that additional 'size_' bytes fit in.
+        //  Used when the rest of a multi-part message doesn't fit into
+        //  the space left.
+        void grow (uint64_t size_);
+
+        //  Maximal number of bytes held in the swap.
+        uint64_t filesize;
+
+        //  Current capacity of the ring. It exceeds 'filesize' only while
+        //  an oversized multi-part message is in the swap.
+        uint64_t capacity;
+
+        //  Current size of the file on the disk.
+        uint64_t allocated;
+
+        //  Position of the oldest message in the file.
+        uint64_t read_pos;
+
+        //  Position where the next message will be written to.
+        uint64_t write_pos;
+
+        //  Position just behind the last committed message.
+        uint64_t commit_pos;
+
+        //  Windows used for writing and reading the messages.
+        window_t write_window;
+        window_t read_window;
+
+        //  The swap file.
+#if defined ZMQ_HAVE_WINDOWS
+        HANDLE fd;
+#else
+        int fd;
+#endif
+
+        swap_t (const swap_t&);
+        void operator = (const swap_t&);
+    };
+
+}
+
+#endif
@@ -24,7 +24,6 @@
 #include "tcp_listener.hpp"
 #include "platform.hpp"
 #include "ip.hpp"
-#include "config.hpp"
 #include "err.hpp"
 
 #ifdef ZMQ_HAVE_WINDOWS
@@ -42,7 +41,8 @@ zmq::tcp_listener_t::~tcp_listener_t ()
         close ();
 }
 
-int zmq::tcp_listener_t::set_address (const char *protocol_, const char *addr_)
+int zmq::tcp_listener_t::set_address (const char *protocol_, const char *addr_,
+    int backlog_)
 {
     //  IPC protocol is not supported on Windows platform.
     if (strcmp (protocol_, "tcp") != 0 ) {
@@ -81,7 +81,7 @@ int zmq::tcp_listener_t::set_address (const char *protocol_, const char *addr_)
     }
 
     //  Listen for incomming connections.
-    rc = listen (s, 1);
+    rc = listen (s, backlog_);
     if (rc == SOCKET_ERROR) {
         wsa_error_to_errno ();
         return -1;
@@ -154,7 +154,8 @@ zmq::tcp_listener_t::~tcp_listener_t ()
         close ();
 }
 
-int zmq::tcp_listener_t::set_address (const char *protocol_, const char *addr_)
+int zmq::tcp_listener_t::set_address (const char *protocol_, const char *addr_,
+    int backlog_)
 {
     if (strcmp (protocol_, "tcp") == 0 ) {
 
@@ -188,7 +189,7 @@ int zmq::tcp_listener_t::set_address (const char *protocol_, const char *addr_)
         }
 
         //  Listen for incomming connections.
-        rc = listen (s, tcp_connection_backlog);
+        rc = listen (s, backlog_);
         if (rc != 0) {
             close ();
             return -1;
@@ -227,7 +228,7 @@ int zmq::tcp_listener_t::set_address (const char *protocol_, const char *addr_)
         }
 
         //  Listen for incomming connections.
-        rc = listen (s, tcp_connection_backlog);
+        rc = listen (s, backlog_);
         if (rc != 0) {
             close ();
             return -1;
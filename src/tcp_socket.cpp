@@ -18,6 +18,8 @@
 */
 
 #include "tcp_socket.hpp"
+#include "encoder.hpp"
+#include "config.hpp"
 #include "platform.hpp"
 #include "err.hpp"
 
@@ -94,6 +96,38 @@ int zmq::tcp_socket_t::write (const void *data, int size)
     return (size_t) nbytes;
 }
 
+int zmq::tcp_socket_t::write (const chunk_t *chunks_, int count_)
+{
+    zmq_assert (count_ <= out_batch_chunks);
+    WSABUF bufs [out_batch_chunks];
+    for (int i = 0; i != count_; i++) {
+        bufs [i].buf = (char*) chunks_ [i].data;
+        bufs [i].len = (ULONG) chunks_ [i].size;
+    }
+
+    DWORD nbytes;
+    int rc = WSASend (s, bufs, count_, &nbytes, 0, NULL, NULL);
+
+    //  If not a single byte can be written to the socket in non-blocking mode
+    //  we'll get an error (this may happen during the speculative write).
+    if (rc == SOCKET_ERROR && WSAGetLastError () == WSAEWOULDBLOCK)
+        return 0;
+
+    //  Signalise peer failure.
+    if (rc == SOCKET_ERROR && (
+          WSAGetLastError () == WSAENETDOWN ||
+          WSAGetLastError () == WSAENETRESET ||
+          WSAGetLastError () == WSAEHOSTUNREACH ||
+          WSAGetLastError () == WSAECONNABORTED ||
+          WSAGetLastError () == WSAETIMEDOUT ||
+          WSAGetLastError () == WSAECONNRESET))
+        return -1;
+
+    wsa_assert (rc != SOCKET_ERROR);
+
+    return (int) nbytes;
+}
+
 int zmq::tcp_socket_t::read (void *data, int size)
 {
     int nbytes = recv (s, (char*) data, size, 0);
@@ -125,8 +159,10 @@ int zmq::tcp_socket_t::read (void *data, int size)
 
 #else
 
+#include <string.h>
 #include <unistd.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <arpa/inet.h>
 #include <netinet/tcp.h>
 #include <netinet/in.h>
@@ -198,6 +234,34 @@ int zmq::tcp_socket_t::write (const void *data, int size)
     return (size_t) nbytes;
 }
 
+int zmq::tcp_socket_t::write (const chunk_t *chunks_, int count_)
+{
+    zmq_assert (count_ <= out_batch_chunks);
+    iovec iov [out_batch_chunks];
+    for (int i = 0; i != count_; i++) {
+        iov [i].iov_base = chunks_ [i].data;
+        iov [i].iov_len = chunks_ [i].size;
+    }
+
+    msghdr msg;
+    memset (&msg, 0, sizeof (msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = count_;
+    ssize_t nbytes = sendmsg (s, &msg, 0);
+
+    //  Same errors as in the case of a simple write are OK.
+    if (nbytes == -1 && (errno == EAGAIN || errno == EWOULDBLOCK ||
+          errno == EINTR))
+        return 0;
+
+    //  Signalise peer failure.
+    if (nbytes == -1 && (errno == ECONNRESET || errno == EPIPE))
+        return -1;
+
+    errno_assert (nbytes != -1);
+    return (size_t) nbytes;
+}
+
 int zmq::tcp_socket_t::read (void *data, int size)
 {
     ssize_t nbytes = recv (s, data, size, 0);
@@ -50,6 +50,10 @@ namespace zmq
         //  of error or orderly shutdown by the other peer -1 is returned.
         int write (const void *data, int size);
 
+        //  Writes data from multiple chunks to the socket using a single
+        //  system call. Return value is the same as in the case of write.
+        int write (const struct chunk_t *chunks_, int count_);
+
         //  Reads data from the socket (up to 'size' bytes). Returns the number
         //  of bytes actually read (even zero is to be considered to be
         //  a success). In case of error or orderly shutdown by the other
@@ -0,0 +1,205 @@
+/*
+    Copyright (c) 2007-2010 iMatix Corporation
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the Lesser GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    Lesser GNU General Public License for more details.
+
+    You should have received a copy of the Lesser GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <new>
+
+#include "timer_wheel.hpp"
+#include "i_poll_events.hpp"
+#include "clock.hpp"
+#include "err.hpp"
+
+zmq::timer_wheel_t::timer_wheel_t () :
+    count (0)
+{
+    for (int level = 0; level != levels; level++)
+        for (int slot = 0; slot != slots; slot++) {
+            wheel [level][slot].prev = &wheel [level][slot];
+            wheel [level][slot].next = &wheel [level][slot];
+        }
+    overflow.prev = &overflow;
+    overflow.next = &overflow;
+
+    current = now ();
+}
+
+zmq::timer_wheel_t::~timer_wheel_t ()
+{
+    //  Deallocate any timers that were not cancelled.
+    for (int level = 0; level != levels; level++)
+        for (int slot = 0; slot != slots; slot++) {
+            timer_t *sentinel = &wheel [level][slot];
+            while (sentinel->next != sentinel) {
+                timer_t *timer = sentinel->next;
+                unlink (timer);
+                delete timer;
+            }
+        }
+    while (overflow.next != &overflow) {
+        timer_t *timer = overflow.next;
+        unlink (timer);
+        delete timer;
+    }
+}
+
+zmq::timer_wheel_t::handle_t zmq::timer_wheel_t::add (int timeout_,
+    i_poll_events *sink_, int id_)
+{
+    zmq_assert (timeout_ >= 0);
+
+    timer_t *timer = new (std::nothrow) timer_t;
+    zmq_assert (timer);
+    timer->expiry = now () + timeout_;
+    timer->sink = sink_;
+    timer->id = id_;
+    link (timer);
+    count++;
+    return timer;
+}
+
+void zmq::timer_wheel_t::cancel (handle_t handle_)
+{
+    timer_t *timer = (timer_t*) handle_;
+    unlink (timer);
+    delete timer;
+    count--;
+}
+
+int zmq::timer_wheel_t::execute ()
+{
+    uint64_t time = now ();
+
+    //  If there are no timers, there's no need to process individual ticks.
+    if (!count) {
+        if (time >= current)
+            current = time + 1;
+        return -1;
+    }
+
+    //  Process all the ticks up to the current time.
+    while (current <= time) {
+
+        //  When the first level wraps around, refill it from the coarser
+        //  levels.
+        int index = (int) (current & (slots - 1));
+        if (!index && !cascade (1) && !cascade (2) && !cascade (3))
+            relink (&overflow);
+        current++;
+
+        //  Fire the timers expiring at this tick. The timers are removed
+        //  from the list one by one as timer handlers may cancel other
+        //  timers. As 'current' was already moved to the next tick, timers
+        //  added by the handlers never get into this slot.
+        timer_t *sentinel = &wheel [0][index];
+        while (sentinel->next != sentinel) {
+            timer_t *timer = sentinel->next;
+            unlink (timer);
+            count--;
+            i_poll_events *sink = timer->sink;
+            int id = timer->id;
+            delete timer;
+            sink->timer_event (id);
+        }
+    }
+
+    if (!count)
+        return -1;
+
+    //  Find the nearest timer in the first level. Don't look past the point
+    //  where the level wraps around; timers from coarser levels may expire
+    //  earlier than the ones beyond that point. If the next tick is the
+    //  wrap-around point itself, the first level is yet to be refilled.
+    int index = (int) (current & (slots - 1));
+    if (!index)
+        return 1;
+    int ticks = 0;
+    while (index + ticks != slots) {
+        timer_t *sentinel = &wheel [0][index + ticks];
+        if (sentinel->next != sentinel)
+            break;
+        ticks++;
+    }
+
+    //  'current' is ahead of the current time by one tick.
+    return ticks + 1;
+}
+
+uint64_t zmq::timer_wheel_t::now ()
+{
+    return now_us () / 1000;
+}
+
+void zmq::timer_wheel_t::link (timer_t *timer_)
+{
+    //  Timers that are already due are processed with the next tick.
+    uint64_t expiry = timer_->expiry;
+    if (expiry < current)
+        expiry = current;
+
+    //  Timer is placed to the finest level where it belongs to the same
+    //  slot of the next coarser level as the current tick. That way slots
+    //  never hold timers from different rounds of the wheel. Timers beyond
+    //  the range of the wheel are kept in the overflow list.
+    int level = 0;
+    while (level != levels && (expiry >> (slot_bits * (level + 1))) !=
+          (current >> (slot_bits * (level + 1))))
+        level++;
+
+    timer_t *sentinel = &overflow;
+    if (level != levels)
+        sentinel = &wheel [level]
+            [(expiry >> (slot_bits * level)) & (slots - 1)];
+    timer_->prev = sentinel->prev;
+    timer_->next = sentinel;
+    sentinel->prev->next = timer_;
+    sentinel->prev = timer_;
+}
+
+void zmq::timer_wheel_t::unlink (timer_t *timer_)
+{
+    timer_->prev->next = timer_->next;
+    timer_->next->prev = timer_->prev;
+}
+
+int zmq::timer_wheel_t::cascade (int level_)
+{
+    int index = (int) ((current >> (slot_bits * level_)) & (slots - 1));
+    relink (&wheel [level_][index]);
+    return index;
+}
+
+void zmq::timer_wheel_t::relink (timer_t *sentinel_)
+{
+    //  Detach the list first so that timers relinked to the same list are
+    //  not processed again.
+    if (sentinel_->next == sentinel_)
+        return;
+    timer_t list;
+    list.next = sentinel_->next;
+    list.prev = sentinel_->prev;
+    list.next->prev = &list;
+    list.prev->next = &list;
+    sentinel_->next = sentinel_;
+    sentinel_->prev = sentinel_;
+
+    while (list.next != &list) {
+        timer_t *timer = list.next;
+        unlink (timer);
+        link (timer);
+    }
+}
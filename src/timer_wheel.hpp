@@ -0,0 +1,116 @@
+/*
+    Copyright (c) 2007-2010 iMatix Corporation
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the Lesser GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    Lesser GNU General Public License for more details.
+
+    You should have received a copy of the Lesser GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_TIMER_WHEEL_HPP_INCLUDED__
+#define __ZMQ_TIMER_WHEEL_HPP_INCLUDED__
+
+#include "platform.hpp"
+#include "stdint.hpp"
+
+namespace zmq
+{
+
+    //  Hierarchical timing wheel used by the pollers. Timers are kept in
+    //  four levels of 256 slots each; the first level has a resolution of
+    //  one millisecond, each subsequent level is 256 times coarser. Timers
+    //  from a coarser level are moved to a finer one when the finer level
+    //  wraps around. Adding and cancelling a timer are O(1) operations.
+    //
+    //  The object is not thread-safe. It is meant to be used exclusively
+    //  from the I/O thread owning the poller.
+
+    class timer_wheel_t
+    {
+    public:
+
+        typedef void* handle_t;
+
+        timer_wheel_t ();
+        ~timer_wheel_t ();
+
+        //  Schedules a timer to expire in timeout_ milliseconds. When it
+        //  expires, timer_event is invoked on sink_ with id_ as argument.
+        //  Returned handle is valid until the timer expires or is cancelled.
+        handle_t add (int timeout_, struct i_poll_events *sink_, int id_);
+
+        //  Cancels a timer that haven't expired yet.
+        void cancel (handle_t handle_);
+
+        //  Executes all the expired timers. Returns number of milliseconds
+        //  to wait before calling the function again, -1 if there are no
+        //  timers registered.
+        int execute ();
+
+    private:
+
+        enum
+        {
+            slot_bits = 8,
+            slots = 1 << slot_bits,
+            levels = 4
+        };
+
+        //  Timer. Timers in the same slot form a circular doubly-linked list
+        //  with the slot's sentinel node so that they can be unlinked in
+        //  constant time.
+        struct timer_t
+        {
+            timer_t *prev;
+            timer_t *next;
+            uint64_t expiry;
+            struct i_poll_events *sink;
+            int id;
+        };
+
+        //  Returns current time in milliseconds using monotonic clock.
+        uint64_t now ();
+
+        //  Places the timer into the appropriate slot.
+        void link (timer_t *timer_);
+
+        //  Removes the timer from its slot.
+        static void unlink (timer_t *timer_);
+
+        //  Moves the timers from the slot of the specified level the current
+        //  tick belongs to to the finer-grained levels. Returns index of
+        //  the slot.
+        int cascade (int level_);
+
+        //  Places all the timers from the list anew.
+        void relink (timer_t *sentinel_);
+
+        //  Sentinels of the slot lists.
+        timer_t wheel [levels][slots];
+
+        //  Timers that expire beyond the range of the wheel.
+        timer_t overflow;
+
+        //  The next tick to be processed.
+        uint64_t current;
+
+        //  Number of the timers registered.
+        int count;
+
+        timer_wheel_t (const timer_wheel_t&);
+        void operator = (const timer_wheel_t&);
+    };
+
+}
+
+#endif
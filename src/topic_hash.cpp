@@ -0,0 +1,135 @@
+/*
+    Copyright (c) 2007-2010 iMatix Corporation
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the Lesser GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    Lesser GNU General Public License for more details.
+
+    You should have received a copy of the Lesser GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <string.h>
+
+#include "topic_hash.hpp"
+#include "hash.hpp"
+
+//  Checks whether the topic at the specified index plus one matches
+//  the data.
+struct topic_eq_t
+{
+    inline topic_eq_t (const unsigned char *topics_, size_t topic_size_,
+          const unsigned char *data_) :
+        topics (topics_),
+        topic_size (topic_size_),
+        data (data_)
+    {
+    }
+
+    inline bool operator () (uint32_t index_) const
+    {
+        return memcmp (topics + (index_ - 1) * topic_size, data,
+            topic_size) == 0;
+    }
+
+    const unsigned char *topics;
+    size_t topic_size;
+    const unsigned char *data;
+};
+
+zmq::topic_hash_t::topic_hash_t () :
+    topic_size (0)
+{
+}
+
+zmq::topic_hash_t::~topic_hash_t ()
+{
+}
+
+bool zmq::topic_hash_t::add (unsigned char *topic_, size_t size_)
+{
+    //  The first topic declares the topic size for the whole set.
+    if (!size_)
+        return false;
+    if (refcnts.empty ())
+        topic_size = size_;
+    if (size_ != topic_size)
+        return false;
+
+    uint32_t h = fnv_hash (topic_, topic_size);
+    if (!refcnts.empty ()) {
+        uint32_t index = table.find (h,
+            topic_eq_t (&topics [0], topic_size, topic_));
+        if (index) {
+            ++refcnts [index - 1];
+            return true;
+        }
+    }
+
+    refcnts.push_back (1);
+    hashes.push_back (h);
+    topics.insert (topics.end (), topic_, topic_ + topic_size);
+    table.insert (h, (uint32_t) refcnts.size ());
+    return true;
+}
+
+bool zmq::topic_hash_t::rm (unsigned char *topic_, size_t size_)
+{
+    if (refcnts.empty () || size_ != topic_size)
+        return false;
+
+    uint32_t h = fnv_hash (topic_, topic_size);
+    uint32_t index = table.find (h,
+        topic_eq_t (&topics [0], topic_size, topic_));
+    if (!index)
+        return false;
+    if (--refcnts [index - 1])
+        return true;
+    table.erase (h, index);
+
+    //  Move the last topic to the place of the removed one.
+    uint32_t last = (uint32_t) refcnts.size ();
+    if (index != last) {
+        table.replace (hashes [last - 1], last, index);
+        refcnts [index - 1] = refcnts [last - 1];
+        hashes [index - 1] = hashes [last - 1];
+        memcpy (&topics [(index - 1) * topic_size],
+            &topics [(last - 1) * topic_size], topic_size);
+    }
+    refcnts.pop_back ();
+    hashes.pop_back ();
+    topics.resize ((last - 1) * topic_size);
+    return true;
+}
+
+bool zmq::topic_hash_t::check (unsigned char *data_, size_t size_)
+{
+    //  This function is on critical path.
+    if (refcnts.empty () || size_ < topic_size)
+        return false;
+
+    return table.find (fnv_hash (data_, topic_size),
+        topic_eq_t (&topics [0], topic_size, data_)) != 0;
+}
+
+void zmq::topic_hash_t::clear ()
+{
+    refcnts.clear ();
+    hashes.clear ();
+    topics.clear ();
+    table.clear ();
+    topic_size = 0;
+}
+
+bool zmq::topic_hash_t::empty ()
+{
+    return refcnts.empty ();
+}
@@ -0,0 +1,76 @@
+/*
+    Copyright (c) 2007-2010 iMatix Corporation
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the Lesser GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    Lesser GNU General Public License for more details.
+
+    You should have received a copy of the Lesser GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_TOPIC_HASH_HPP_INCLUDED__
+#define __ZMQ_TOPIC_HASH_HPP_INCLUDED__
+
+#include <stddef.h>
+#include <vector>
+
+#include "stdint.hpp"
+#include "hash_table.hpp"
+
+namespace zmq
+{
+
+    //  Set of exact-match subscriptions with reference counting. All the
+    //  topics have the same size, declared by the first topic added. A message
+    //  matches if its first 'topic_size' bytes are equal to one of the topics,
+    //  which takes a single probe of an open-addressing hash table instead of
+    //  a character-by-character walk of the prefix tree.
+
+    class topic_hash_t
+    {
+    public:
+
+        topic_hash_t ();
+        ~topic_hash_t ();
+
+        //  Adding fails if the size of the topic differs from the size of
+        //  the topics already in the set.
+        bool add (unsigned char *topic_, size_t size_);
+        bool rm (unsigned char *topic_, size_t size_);
+        bool check (unsigned char *data_, size_t size_);
+
+        //  Removes all the topics.
+        void clear ();
+
+        bool empty ();
+
+    private:
+
+        //  Size of the topics. Zero if there are no topics yet.
+        size_t topic_size;
+
+        //  Distinct topics along with their reference counts and hashes.
+        //  Topic i is stored at offset i * topic_size in 'topics' array.
+        std::vector <uint32_t> refcnts;
+        std::vector <uint32_t> hashes;
+        std::vector <unsigned char> topics;
+
+        //  Maps the hashes of the topics to their indices plus one.
+        hash_table_t <uint32_t> table;
+
+        topic_hash_t (const topic_hash_t&);
+        void operator = (const topic_hash_t&);
+    };
+
+}
+
+#endif
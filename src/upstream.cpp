@@ -70,7 +70,9 @@ void zmq::upstream_t::xrevive (class writer_t *pipe_)
 int zmq::upstream_t::xsetsockopt (int option_, const void *optval_,
     size_t optvallen_)
 {
-    //  No special options for this socket type.
+    if (option_ == ZMQ_QUANTUM)
+        return fq.set_quantum (optval_, optvallen_);
+
     errno = EINVAL;
     return -1;
 }
@@ -86,6 +88,11 @@ int zmq::upstream_t::xrecv (zmq_msg_t *msg_, int flags_)
     return fq.recv (msg_, flags_);
 }
 
+void zmq::upstream_t::xflush ()
+{
+    //  There are no outpipes, so there's nothing to flush.
+}
+
 bool zmq::upstream_t::xhas_in ()
 {
     return fq.has_in ();
@@ -17,14 +17,47 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <string.h>
+
 #include "../include/zmq.h"
 
 #include "xrep.hpp"
 #include "err.hpp"
 #include "pipe.hpp"
+#include "uuid.hpp"
+#include "hash.hpp"
+
+//  Checks whether the pipe leads to the peer with the specified identity.
+struct identity_eq_t
+{
+    inline identity_eq_t (const std::vector <zmq::blob_t> &identities_,
+          const unsigned char *data_, size_t size_) :
+        identities (identities_),
+        data (data_),
+        size (size_)
+    {
+    }
+
+    inline bool operator () (zmq::writer_t *pipe_) const
+    {
+        const zmq::blob_t &identity = identities [pipe_->get_yarray_index ()];
+        return identity.size () == size &&
+            memcmp (identity.data (), data, size) == 0;
+    }
+
+    const std::vector <zmq::blob_t> &identities;
+    const unsigned char *data;
+    size_t size;
+};
 
 zmq::xrep_t::xrep_t (class app_thread_t *parent_) :
-    socket_base_t (parent_)
+    socket_base_t (parent_),
+    active (0),
+    current (0),
+    more_in (false),
+    prefetched (false),
+    current_out (NULL),
+    more_out (false)
 {
     options.requires_in = true;
     options.requires_out = true;
@@ -33,51 +66,112 @@ zmq::xrep_t::xrep_t (class app_thread_t *parent_) :
     //  That way we are aware of the peer's identity when binding to the pipes.
     options.immediate_connect = false;
 
-    //  XREP is unfunctional at the moment. Crash here!
-    zmq_assert (false);
+    zmq_msg_init (&prefetched_msg);
 }
 
 zmq::xrep_t::~xrep_t ()
 {
+    for (in_pipes_t::size_type i = 0; i != in_pipes.size (); i++) {
+        if (in_pipes [i])
+            in_pipes [i]->term ();
+        if (out_pipes [i])
+            out_pipes [i]->term ();
+    }
+
+    zmq_msg_close (&prefetched_msg);
 }
 
 void zmq::xrep_t::xattach_pipes (class reader_t *inpipe_,
     class writer_t *outpipe_, const blob_t &peer_identity_)
 {
     zmq_assert (inpipe_ && outpipe_);
-    fq.attach (inpipe_);
 
-    //  TODO: What if new connection has same peer identity as the old one?
-    bool ok = outpipes.insert (std::make_pair (
-        peer_identity_, outpipe_)).second;
-    zmq_assert (ok);
+    //  Peers connected via inproc without an identity have none. Generate
+    //  a unique one the same way it is done for other transports.
+    blob_t identity (peer_identity_);
+    if (identity.empty ()) {
+        unsigned char buf [uuid_t::uuid_blob_len + 1];
+        buf [0] = 0;
+        memcpy (buf + 1, uuid_t ().to_blob (), uuid_t::uuid_blob_len);
+        identity.assign (buf, uuid_t::uuid_blob_len + 1);
+    }
+
+    in_pipes.push_back (inpipe_);
+    out_pipes.push_back (outpipe_);
+    identities.push_back (identity);
+    drr.push_back ();
+    swap_peers (active, in_pipes.size () - 1);
+    active++;
+
+    //  If there's a peer with the same identity already, the new connection
+    //  takes the route over. The old peer can still send messages, however,
+    //  it doesn't get any replies anymore.
+    writer_t *old_pipe = find_route (identity.data (), identity.size ());
+    if (old_pipe)
+        rm_route (identity, old_pipe);
+    add_route (identity, outpipe_);
 }
 
 void zmq::xrep_t::xdetach_inpipe (class reader_t *pipe_)
 {
     zmq_assert (pipe_);
-    fq.detach (pipe_);
+    zmq_assert (!(more_in || prefetched) || in_pipes [current] != pipe_);
+
+    //  Move the peer to the list of passive peers.
+    in_pipes_t::size_type index = in_pipes.index (pipe_);
+    if (index < active) {
+        active--;
+        if (current == active)
+            current = 0;
+        swap_peers (index, active);
+        index = active;
+    }
+
+    //  If the outbound pipe is still in place, keep the peer so that
+    //  messages can be still routed to it.
+    if (out_pipes [index]) {
+        in_pipes [index] = NULL;
+        return;
+    }
+    erase_peer (index);
 }
 
 void zmq::xrep_t::xdetach_outpipe (class writer_t *pipe_)
 {
-    for (outpipes_t::iterator it = outpipes.begin ();
-          it != outpipes.end (); ++it)
-        if (it->second == pipe_) {
-            outpipes.erase (it);
-            return;
-        }
-    zmq_assert (false);
+    zmq_assert (pipe_);
+
+    //  If the peer disconnects in the middle of a message, the rest of
+    //  the message is dropped.
+    if (pipe_ == current_out)
+        current_out = NULL;
+
+    out_pipes_t::size_type index = out_pipes.index (pipe_);
+    rm_route (identities [index], pipe_);
+
+    //  If the inbound pipe is still in place, keep the peer so that the
+    //  messages from it are delivered along with its identity.
+    if (in_pipes [index]) {
+        out_pipes [index] = NULL;
+        return;
+    }
+    erase_peer (index);
 }
 
 void zmq::xrep_t::xkill (class reader_t *pipe_)
 {
-    fq.kill (pipe_);
+    //  Move the pipe to the list of inactive pipes.
+    active--;
+    if (current == active)
+        current = 0;
+    swap_peers (in_pipes.index (pipe_), active);
+    drr.deactivate (active);
 }
 
 void zmq::xrep_t::xrevive (class reader_t *pipe_)
 {
-    fq.revive (pipe_);
+    //  Move the pipe to the list of active pipes.
+    swap_peers (in_pipes.index (pipe_), active);
+    active++;
 }
 
 void zmq::xrep_t::xrevive (class writer_t *pipe_)
@@ -87,25 +181,28 @@ void zmq::xrep_t::xrevive (class writer_t *pipe_)
 int zmq::xrep_t::xsetsockopt (int option_, const void *optval_,
     size_t optvallen_)
 {
+    if (option_ == ZMQ_QUANTUM)
+        return drr.set_quantum (optval_, optvallen_);
+
     errno = EINVAL;
     return -1;
 }
 
 int zmq::xrep_t::xsend (zmq_msg_t *msg_, int flags_)
 {
-    unsigned char *data = (unsigned char*) zmq_msg_data (msg_);
-    size_t size = zmq_msg_size (msg_);
-
-    //  Check whether the message is well-formed.
-    zmq_assert (size >= 1);
-    zmq_assert (size_t (*data + 1) <= size);
-
-    //  Find the corresponding outbound pipe. If there's none, just drop the
-    //  message.
-    //  TODO: There's an allocation here! It's the critical path! Get rid of it!
-    blob_t identity (data + 1, *data);
-    outpipes_t::iterator it = outpipes.find (identity);
-    if (it == outpipes.end ()) {
+    //  The first part of the message is the identity of the peer. Find
+    //  the corresponding outbound pipe. If there's none, the whole message
+    //  is dropped. If the pipe is full, the message is refused as a whole
+    //  so that it can be re-sent later on.
+    if (!more_out) {
+        writer_t *pipe = find_route ((unsigned char*) zmq_msg_data (msg_),
+            zmq_msg_size (msg_));
+        if (pipe && !pipe->check_write ()) {
+            errno = EAGAIN;
+            return -1;
+        }
+        more_out = msg_->flags & ZMQ_MSG_MORE;
+        current_out = more_out ? pipe : NULL;
         int rc = zmq_msg_close (msg_);
         zmq_assert (rc == 0);
         rc = zmq_msg_init (msg_);
@@ -113,13 +210,24 @@ int zmq::xrep_t::xsend (zmq_msg_t *msg_, int flags_)
         return 0;
     }
 
-    //  Push message to the selected pipe.
-    if (!it->second->write (msg_)) {
-        errno = EAGAIN;
-        return -1;
-    }
+    more_out = msg_->flags & ZMQ_MSG_MORE;
 
-    it->second->flush ();
+    //  Push message to the selected pipe. The high watermark is checked only
+    //  for the first part of the message, so the subsequent parts can fail
+    //  only if the swap is full. In such a case the message is dropped.
+    if (current_out && !current_out->write (msg_)) {
+        current_out->rollback ();
+        current_out = NULL;
+    }
+    if (!current_out) {
+        int rc = zmq_msg_close (msg_);
+        zmq_assert (rc == 0);
+    }
+    else if (!more_out) {
+        if (!(flags_ & send_noflush))
+            current_out->flush ();
+        current_out = NULL;
+    }
 
     //  Detach the message from the data buffer.
     int rc = zmq_msg_init (msg_);
@@ -130,12 +238,108 @@ int zmq::xrep_t::xsend (zmq_msg_t *msg_, int flags_)
 
 int zmq::xrep_t::xrecv (zmq_msg_t *msg_, int flags_)
 {
-    return fq.recv (msg_, flags_);
+    //  If the identity of the peer was already returned, return the first
+    //  part of the message itself. Subsequent parts are read from the pipe
+    //  the first part came from.
+    if (prefetched || more_in) {
+        if (prefetched) {
+            zmq_msg_move (msg_, &prefetched_msg);
+            prefetched = false;
+        }
+        else {
+            zmq_msg_close (msg_);
+            bool fetched = in_pipes [current]->read (msg_);
+            zmq_assert (fetched);
+            drr.charge (current, zmq_msg_size (msg_));
+        }
+        more_in = msg_->flags & ZMQ_MSG_MORE;
+
+        //  With deficit round robin the peer keeps its turn while it
+        //  has credit left.
+        if (!more_in && !drr.enabled ())
+            next_in ();
+        return 0;
+    }
+
+    //  Deallocate old content of the message.
+    zmq_msg_close (msg_);
+
+    //  Number of peers in a row that were found to have no credit.
+    in_pipes_t::size_type skipped = 0;
+
+    //  Round-robin over the pipes to get the next message. Note that when
+    //  message is not fetched, current pipe is killed and replaced by another
+    //  active pipe. Thus we don't have to increase the 'current' pointer.
+    //  As every failed read deactivates a pipe, the loop ends once there
+    //  are no more messages to read.
+    while (active) {
+
+        //  With deficit round robin, once the peer has used up its credit,
+        //  pass the turn to the next one.
+        if (drr.enabled () && !drr.has_credit (current)) {
+            drr.pass_turn (current, active, skipped);
+            continue;
+        }
+
+        skipped = 0;
+        if (in_pipes [current]->read (&prefetched_msg)) {
+            drr.charge (current, zmq_msg_size (&prefetched_msg));
+
+            //  Return the identity of the peer first. Identities are short
+            //  so this doesn't require an allocation.
+            const blob_t &identity = identities [current];
+            int rc = zmq_msg_init_size (msg_, identity.size ());
+            zmq_assert (rc == 0);
+            memcpy (zmq_msg_data (msg_), identity.data (), identity.size ());
+            msg_->flags |= ZMQ_MSG_MORE;
+            prefetched = true;
+            return 0;
+        }
+    }
+
+    //  No message is available. Initialise the output parameter
+    //  to be a 0-byte message.
+    zmq_msg_init (msg_);
+    errno = EAGAIN;
+    return -1;
+}
+
+void zmq::xrep_t::xflush ()
+{
+    for (out_pipes_t::size_type i = 0; i != out_pipes.size (); i++)
+        if (out_pipes [i])
+            out_pipes [i]->flush ();
 }
 
 bool zmq::xrep_t::xhas_in ()
 {
-    return fq.has_in ();
+    //  There are subsequent parts of the partly-read message available.
+    if (prefetched || more_in)
+        return true;
+
+    //  With deficit round robin the turn can't be passed to another peer
+    //  as the current one may have credit left. Pipes with no messages
+    //  are deactivated and replaced by other active pipes though.
+    if (drr.enabled ()) {
+        while (active)
+            if (in_pipes [current]->check_read ())
+                return true;
+        return false;
+    }
+
+    //  Note that messing with current doesn't break the fairness of fair
+    //  queueing algorithm. If there are no messages available current will
+    //  get back to its original value. Otherwise it'll point to the first
+    //  pipe holding messages, skipping only pipes with no messages available.
+    for (int count = active; count != 0; count--) {
+        if (in_pipes [current]->check_read ())
+            return true;
+        current++;
+        if (current >= active)
+            current = 0;
+    }
+
+    return false;
 }
 
 bool zmq::xrep_t::xhas_out ()
@@ -146,4 +350,46 @@ bool zmq::xrep_t::xhas_out ()
     return true;
 }
 
+void zmq::xrep_t::swap_peers (in_pipes_t::size_type index1_,
+    in_pipes_t::size_type index2_)
+{
+    in_pipes.swap (index1_, index2_);
+    out_pipes.swap (index1_, index2_);
+    identities [index1_].swap (identities [index2_]);
+    drr.swap (index1_, index2_);
+}
+
+void zmq::xrep_t::erase_peer (in_pipes_t::size_type index_)
+{
+    in_pipes.erase (index_);
+    out_pipes.erase (index_);
+    identities [index_].swap (identities.back ());
+    identities.pop_back ();
+    drr.erase (index_);
+}
+
+void zmq::xrep_t::next_in ()
+{
+    current++;
+    if (current >= active)
+        current = 0;
+}
+
+zmq::writer_t *zmq::xrep_t::find_route (const unsigned char *data_,
+    size_t size_)
+{
+    //  This function is on critical path. The identity is compared in place
+    //  rather than copied to a blob.
+    return routes.find (fnv_hash (data_, size_),
+        identity_eq_t (identities, data_, size_));
+}
 
+void zmq::xrep_t::add_route (const blob_t &identity_, writer_t *pipe_)
+{
+    routes.insert (fnv_hash (identity_.data (), identity_.size ()), pipe_);
+}
+
+void zmq::xrep_t::rm_route (const blob_t &identity_, writer_t *pipe_)
+{
+    routes.erase (fnv_hash (identity_.data (), identity_.size ()), pipe_);
+}
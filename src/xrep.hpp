@@ -20,15 +20,23 @@
 #ifndef __ZMQ_XREP_HPP_INCLUDED__
 #define __ZMQ_XREP_HPP_INCLUDED__
 
-#include <map>
+#include <vector>
 
 #include "socket_base.hpp"
+#include "stdint.hpp"
+#include "yarray.hpp"
 #include "blob.hpp"
-#include "fq.hpp"
+#include "drr.hpp"
+#include "hash_table.hpp"
 
 namespace zmq
 {
 
+    //  Each message received from XREP socket is prefixed by a message part
+    //  holding the identity of the peer it came from. Each message sent
+    //  has to be prefixed by a part holding the identity of the peer it is
+    //  to be routed to.
+
     class xrep_t : public socket_base_t
     {
     public:
@@ -47,17 +55,72 @@ namespace zmq
         int xsetsockopt (int option_, const void *optval_, size_t optvallen_);
         int xsend (zmq_msg_t *msg_, int flags_);
         int xrecv (zmq_msg_t *msg_, int flags_);
+        void xflush ();
         bool xhas_in ();
         bool xhas_out ();
 
     private:
 
-        //  Inbound messages are fair-queued.
-        fq_t fq;
-
-        //  Outbound pipes indexed by the peer names.
-        typedef std::map <blob_t, class writer_t*> outpipes_t;
-        outpipes_t outpipes;
+        //  Inbound and outbound pipes of the peers. Pipes connected to the
+        //  same peer are stored at the same index in both arrays and so is
+        //  the peer's identity in 'identities'. Either of the pipes may be
+        //  NULL if it was already detached.
+        typedef yarray_t <class reader_t> in_pipes_t;
+        in_pipes_t in_pipes;
+        typedef yarray_t <class writer_t> out_pipes_t;
+        out_pipes_t out_pipes;
+        typedef std::vector <blob_t> identities_t;
+        identities_t identities;
+
+        //  Swaps two peers, i.e. their pipes and identities.
+        void swap_peers (in_pipes_t::size_type index1_,
+            in_pipes_t::size_type index2_);
+
+        //  Removes the peer from the arrays. The last peer is moved
+        //  to its place.
+        void erase_peer (in_pipes_t::size_type index_);
+
+        //  Maintenance of the routing table. Removing the route does
+        //  nothing if the identity is routed to a different pipe.
+        class writer_t *find_route (const unsigned char *data_, size_t size_);
+        void add_route (const blob_t &identity_, class writer_t *pipe_);
+        void rm_route (const blob_t &identity_, class writer_t *pipe_);
+
+        //  Number of active inpipes. All the active inpipes are located at the
+        //  beginning of the in_pipes array.
+        in_pipes_t::size_type active;
+
+        //  Index of the next inpipe to read a message from.
+        in_pipes_t::size_type current;
+
+        //  If true, part of a multipart message was already received, but
+        //  there are following parts still waiting in the current pipe.
+        bool more_in;
+
+        //  Credits of the peers for deficit round robin, stored at the same
+        //  indices as their pipes.
+        drr_t drr;
+
+        //  Passes the turn to the next active inpipe.
+        void next_in ();
+
+        //  If true, the identity of the peer was already returned and
+        //  'prefetched_msg' holds the first part of the message itself.
+        bool prefetched;
+        zmq_msg_t prefetched_msg;
+
+        //  Pipe the message being sent is routed to. NULL if the message
+        //  is being dropped.
+        class writer_t *current_out;
+
+        //  If true, part of a multipart message was already sent, but
+        //  there are following parts still to be sent.
+        bool more_out;
+
+        //  Table mapping peer identities to outbound pipes. The identities
+        //  themselves are stored in 'identities'.
+        typedef hash_table_t <class writer_t*> routes_t;
+        routes_t routes;
 
         xrep_t (const xrep_t&);
         void operator = (const xrep_t&);
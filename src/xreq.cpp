@@ -38,7 +38,7 @@ void zmq::xreq_t::xattach_pipes (class reader_t *inpipe_,
 {
     zmq_assert (inpipe_ && outpipe_);
     fq.attach (inpipe_);
-    lb.attach (outpipe_);
+    lb.attach (outpipe_, peer_identity_);
 }
 
 void zmq::xreq_t::xdetach_inpipe (class reader_t *pipe_)
@@ -71,6 +71,13 @@ void zmq::xreq_t::xrevive (class writer_t *pipe_)
 int zmq::xreq_t::xsetsockopt (int option_, const void *optval_,
     size_t optvallen_)
 {
+    if (option_ == ZMQ_BALANCE)
+        return lb.set_balance (optval_, optvallen_);
+    if (option_ == ZMQ_BALANCE_KEY_SIZE)
+        return lb.set_key_size (optval_, optvallen_);
+    if (option_ == ZMQ_QUANTUM)
+        return fq.set_quantum (optval_, optvallen_);
+
     errno = EINVAL;
     return -1;
 }
@@ -85,6 +92,11 @@ int zmq::xreq_t::xrecv (zmq_msg_t *msg_, int flags_)
     return fq.recv (msg_, flags_);
 }
 
+void zmq::xreq_t::xflush ()
+{
+    lb.flush ();
+}
+
 bool zmq::xreq_t::xhas_in ()
 {
     return fq.has_in ();
@@ -18,6 +18,13 @@
 */
 
 #include "ypollset.hpp"
+#include "err.hpp"
+
+#if defined ZMQ_YPOLLSET_FUTEX
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#endif
 
 zmq::ypollset_t::ypollset_t ()
 {
@@ -27,20 +34,38 @@ zmq::ypollset_t::~ypollset_t ()
 {
 }
 
-void zmq::ypollset_t::signal (int signal_)
+void zmq::ypollset_t::signal ()
 {
-    zmq_assert (signal_ >= 0 && signal_ < wait_signal);
-    if (bits.btsr (signal_, wait_signal))
-        sem.post (); 
+    if (bits.btsr (signal_bit, wait_signal)) {
+#if defined ZMQ_YPOLLSET_FUTEX
+        //  The waiting thread may not be asleep yet. That's OK as it won't
+        //  fall asleep once the wait signal is reset.
+        long rc = syscall (SYS_futex, (int*) bits.get_address (),
+            (int) FUTEX_WAKE_PRIVATE, (int) 1, NULL, NULL, (int) 0);
+        errno_assert (rc != -1);
+#else
+        sem.post ();
+#endif
+    }
 }
 
-uint64_t zmq::ypollset_t::poll ()
+void zmq::ypollset_t::poll ()
 {
     signals_t result = 0;
-    while (!result) {
+    while (!(result & (signals_t (1) << signal_bit))) {
         result = bits.izte (signals_t (1) << wait_signal, 0);
         if (!result) {
+#if defined ZMQ_YPOLLSET_FUTEX
+            //  Sleep only if the bitmap still holds nothing but the wait
+            //  signal. The wake-up may be spurious, thus the signal bit is
+            //  checked afterwards.
+            long rc = syscall (SYS_futex, (int*) bits.get_address (),
+                (int) FUTEX_WAIT_PRIVATE, (int) (1u << wait_signal), NULL,
+                NULL, (int) 0);
+            errno_assert (rc == 0 || errno == EAGAIN || errno == EINTR);
+#else
             sem.wait ();
+#endif
             result = bits.xchg (0);
         }
 
@@ -51,12 +76,11 @@ uint64_t zmq::ypollset_t::poll ()
         //  operation (set and reset). In such case looping can occur
         //  sporadically.
     }
-    return (uint64_t) result;      
 }
 
-uint64_t zmq::ypollset_t::check ()
+bool zmq::ypollset_t::check ()
 {
-    return (uint64_t) bits.xchg (0);
+    return bits.xchg (0) != 0;
 }
 
 zmq::fd_t zmq::ypollset_t::get_fd ()
@@ -20,16 +20,25 @@
 #ifndef __ZMQ_YPOLLSET_HPP_INCLUDED__
 #define __ZMQ_YPOLLSET_HPP_INCLUDED__
 
+#include "platform.hpp"
 #include "i_signaler.hpp"
-#include "simple_semaphore.hpp"
 #include "atomic_bitmap.hpp"
 
+//  On Linux the waiting thread sleeps on the bitmap itself using futex.
+//  Elsewhere it sleeps on a semaphore.
+#if defined ZMQ_HAVE_LINUX
+#define ZMQ_YPOLLSET_FUTEX
+#else
+#include "simple_semaphore.hpp"
+#endif
+
 namespace zmq
 {
 
-    //  ypollset allows for rapid polling for up to constant number of  
-    //  different signals each produced by a different thread. The number of
-    //  possible signals is platform-dependent.
+    //  ypollset allows for rapid polling for signals produced by any number
+    //  of threads. Fast path of both sending and checking for a signal is
+    //  a single atomic operation. Semaphore (futex on Linux) is used only if
+    //  the receiving thread is actually asleep.
 
     class ypollset_t : public i_signaler
     {
@@ -39,9 +48,9 @@ namespace zmq
         ~ypollset_t ();
 
         //  i_signaler interface implementation.
-        void signal (int signal_);
-        uint64_t poll ();
-        uint64_t check ();
+        void signal ();
+        void poll ();
+        bool check ();
         fd_t get_fd ();
 
     private:
@@ -49,15 +58,28 @@ namespace zmq
         //  Internal representation of signal bitmap.
         typedef atomic_bitmap_t::bitmap_t signals_t;
 
-        //  Wait signal is carried in the most significant bit of integer.
-        enum {wait_signal = sizeof (signals_t) * 8 - 1};
+        //  Signal is carried in the least significant bit of integer, wait
+        //  signal in the most significant bit. Futex operates on 32-bit
+        //  integers, so with futex the wait signal is the most significant
+        //  bit of the lower 32 bits. (64-bit bitmaps are used on x86-64 only,
+        //  i.e. the lower 32 bits are the ones at the bitmap's address.)
+        enum {
+            signal_bit = 0,
+#if defined ZMQ_YPOLLSET_FUTEX
+            wait_signal = 31
+#else
+            wait_signal = sizeof (signals_t) * 8 - 1
+#endif
+        };
 
         //  The bits of the pollset.
         atomic_bitmap_t bits;
 
+#if !defined ZMQ_YPOLLSET_FUTEX
         //  Used by thread waiting for signals to sleep if there are no
         //  signals available.
         simple_semaphore_t sem;
+#endif
 
         //  Disable copying of ypollset object.
         ypollset_t (const ypollset_t&);
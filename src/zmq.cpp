@@ -28,6 +28,9 @@
 #include "app_thread.hpp"
 #include "dispatcher.hpp"
 #include "msg_content.hpp"
+#include "msg_pool.hpp"
+#include "socket_poller.hpp"
+#include "clock.hpp"
 #include "platform.hpp"
 #include "stdint.hpp"
 #include "config.hpp"
@@ -44,6 +47,7 @@
 
 #if !defined ZMQ_HAVE_WINDOWS
 #include <unistd.h>
+#include <time.h>
 #include <sys/time.h>
 #endif
 
@@ -109,8 +113,8 @@ int zmq_msg_init_size (zmq_msg_t *msg_, size_t size_)
         msg_->vsm_size = (uint8_t) size_;
     }
     else {
-        msg_->content =
-            (zmq::msg_content_t*) malloc (sizeof (zmq::msg_content_t) + size_);
+        msg_->content = (zmq::msg_content_t*) zmq::msg_pool_t::allocate (
+            sizeof (zmq::msg_content_t) + size_);
         if (!msg_->content) {
             errno = ENOMEM;
             return -1;
@@ -123,6 +127,7 @@ int zmq_msg_init_size (zmq_msg_t *msg_, size_t size_)
         content->ffn = NULL;
         content->hint = NULL;
         new (&content->refcnt) zmq::atomic_counter_t ();
+        content->embedded = false;
     }
     return 0;
 }
@@ -130,7 +135,8 @@ int zmq_msg_init_size (zmq_msg_t *msg_, size_t size_)
 int zmq_msg_init_data (zmq_msg_t *msg_, void *data_, size_t size_,
     zmq_free_fn *ffn_, void *hint_)
 {
-    msg_->content = (zmq::msg_content_t*) malloc (sizeof (zmq::msg_content_t));
+    msg_->content = (zmq::msg_content_t*) zmq::msg_pool_t::allocate (
+        sizeof (zmq::msg_content_t));
     zmq_assert (msg_->content);
     msg_->flags = 0;
     zmq::msg_content_t *content = (zmq::msg_content_t*) msg_->content;
@@ -139,6 +145,7 @@ int zmq_msg_init_data (zmq_msg_t *msg_, void *data_, size_t size_,
     content->ffn = ffn_;
     content->hint = hint_;
     new (&content->refcnt) zmq::atomic_counter_t ();
+    content->embedded = false;
     return 0;
 }
 
@@ -158,9 +165,13 @@ int zmq_msg_close (zmq_msg_t *msg_)
         //  counter so we call its destructor now.
         content->refcnt.~atomic_counter_t ();
 
+        //  Embedded content may be deallocated by ffn, thus the flag has
+        //  to be checked beforehand.
+        bool embedded = content->embedded;
         if (content->ffn)
             content->ffn (content->data, content->hint);
-        free (content);
+        if (!embedded)
+            zmq::msg_pool_t::deallocate (content);
     }
 
     return 0;
@@ -222,8 +233,7 @@ void *zmq_init (int app_threads_, int io_threads_, int flags_)
     //  There should be at least a single application thread managed
     //  by the dispatcher. There's no need for I/O threads if 0MQ is used
     //  only for inproc messaging
-    if (app_threads_ < 1 || io_threads_ < 0 ||
-          app_threads_ > 63 || io_threads_ > 63) {
+    if (app_threads_ < 1 || io_threads_ < 0) {
         errno = EINVAL;
         return NULL;
     }
@@ -280,6 +290,13 @@ int zmq_term (void *dispatcher_)
     return rc;
 }
 
+int zmq_setctxopt (void *dispatcher_, int option_, const void *optval_,
+    size_t optvallen_)
+{
+    return (((zmq::dispatcher_t*) dispatcher_)->setctxopt (option_, optval_,
+        optvallen_));
+}
+
 void *zmq_socket (void *dispatcher_, int type_)
 {
     return (void*) (((zmq::dispatcher_t*) dispatcher_)->create_socket (type_));
@@ -298,6 +315,12 @@ int zmq_setsockopt (void *s_, int option_, const void *optval_,
         optvallen_));
 }
 
+int zmq_getsockopt (void *s_, int option_, void *optval_, size_t *optvallen_)
+{
+    return (((zmq::socket_base_t*) s_)->getsockopt (option_, optval_,
+        optvallen_));
+}
+
 int zmq_bind (void *s_, const char *addr_)
 {
     return (((zmq::socket_base_t*) s_)->bind (addr_));
@@ -310,6 +333,9 @@ int zmq_connect (void *s_, const char *addr_)
 
 int zmq_send (void *s_, zmq_msg_t *msg_, int flags_)
 {
+    //  Strip the flags not defined by the API so that the user can't
+    //  accidentally set internal ones, such as send_noflush.
+    flags_ &= ZMQ_NOBLOCK | ZMQ_MORE;
     return (((zmq::socket_base_t*) s_)->send (msg_, flags_));
 }
 
@@ -318,6 +344,17 @@ int zmq_recv (void *s_, zmq_msg_t *msg_, int flags_)
     return (((zmq::socket_base_t*) s_)->recv (msg_, flags_));
 }
 
+int zmq_sendv (void *s_, zmq_msg_t *msgs_, size_t count_, int flags_)
+{
+    flags_ &= ZMQ_NOBLOCK | ZMQ_MORE;
+    return (((zmq::socket_base_t*) s_)->sendv (msgs_, count_, flags_));
+}
+
+int zmq_recvv (void *s_, zmq_msg_t *msgs_, size_t count_, int flags_)
+{
+    return (((zmq::socket_base_t*) s_)->recvv (msgs_, count_, flags_));
+}
+
 int zmq_poll (zmq_pollitem_t *items_, int nitems_, long timeout_)
 {
 #if defined ZMQ_HAVE_LINUX || defined ZMQ_HAVE_FREEBSD ||\
@@ -393,7 +430,7 @@ int zmq_poll (zmq_pollitem_t *items_, int nitems_, long timeout_)
 
         //  Process 0MQ commands if needed.
         if (nsockets && pollfds [npollfds -1].revents & POLLIN)
-            app_thread->process_commands (false, false);
+            app_thread->process_signaled_commands ();
 
         //  Check for the events.
         int pollfd_pos = 0;
@@ -545,7 +582,7 @@ int zmq_poll (zmq_pollitem_t *items_, int nitems_, long timeout_)
 
         //  Process 0MQ commands if needed.
         if (nsockets && FD_ISSET (notify_fd, &inset))
-            app_thread->process_commands (false, false);
+            app_thread->process_signaled_commands ();
 
         //  Check for the events.
         for (int i = 0; i != nitems_; i++) {
@@ -623,6 +660,88 @@ int zmq_poll (zmq_pollitem_t *items_, int nitems_, long timeout_)
 #endif
 }
 
+#if defined ZMQ_HAVE_LINUX || defined ZMQ_HAVE_FREEBSD ||\
+    defined ZMQ_HAVE_OPENBSD || defined ZMQ_HAVE_SOLARIS ||\
+    defined ZMQ_HAVE_OSX || defined ZMQ_HAVE_QNXNTO ||\
+    defined ZMQ_HAVE_HPUX || defined ZMQ_HAVE_AIX ||\
+    defined ZMQ_HAVE_NETBSD
+
+void *zmq_poller_new ()
+{
+    zmq::socket_poller_t *poller = new (std::nothrow) zmq::socket_poller_t;
+    zmq_assert (poller);
+    return (void*) poller;
+}
+
+int zmq_poller_close (void *poller_)
+{
+    delete (zmq::socket_poller_t*) poller_;
+    return 0;
+}
+
+int zmq_poller_add (void *poller_, zmq_pollitem_t *item_)
+{
+    return ((zmq::socket_poller_t*) poller_)->add (item_);
+}
+
+int zmq_poller_modify (void *poller_, zmq_pollitem_t *item_)
+{
+    return ((zmq::socket_poller_t*) poller_)->modify (item_);
+}
+
+int zmq_poller_remove (void *poller_, zmq_pollitem_t *item_)
+{
+    return ((zmq::socket_poller_t*) poller_)->remove (item_);
+}
+
+int zmq_poller_wait (void *poller_, zmq_pollitem_t *items_, int nitems_,
+    long timeout_)
+{
+    return ((zmq::socket_poller_t*) poller_)->wait (items_, nitems_,
+        timeout_);
+}
+
+#else
+
+void *zmq_poller_new ()
+{
+    errno = ENOTSUP;
+    return NULL;
+}
+
+int zmq_poller_close (void *poller_)
+{
+    errno = ENOTSUP;
+    return -1;
+}
+
+int zmq_poller_add (void *poller_, zmq_pollitem_t *item_)
+{
+    errno = ENOTSUP;
+    return -1;
+}
+
+int zmq_poller_modify (void *poller_, zmq_pollitem_t *item_)
+{
+    errno = ENOTSUP;
+    return -1;
+}
+
+int zmq_poller_remove (void *poller_, zmq_pollitem_t *item_)
+{
+    errno = ENOTSUP;
+    return -1;
+}
+
+int zmq_poller_wait (void *poller_, zmq_pollitem_t *items_, int nitems_,
+    long timeout_)
+{
+    errno = ENOTSUP;
+    return -1;
+}
+
+#endif
+
 int zmq_errno ()
 {
     return errno;
@@ -630,20 +749,13 @@ int zmq_errno ()
 
 #if defined ZMQ_HAVE_WINDOWS
 
-static uint64_t now ()
-{    
-    //  Get the high resolution counter's accuracy.
+double zmq_clock ()
+{
     LARGE_INTEGER ticksPerSecond;
     QueryPerformanceFrequency (&ticksPerSecond);
-
-    //  What time is it?
     LARGE_INTEGER tick;
     QueryPerformanceCounter (&tick);
-
-    //  Convert the tick number into the number of seconds
-    //  since the system was started.
-    double ticks_div = (double) (ticksPerSecond.QuadPart / 1000000);     
-    return (uint64_t) (tick.QuadPart / ticks_div);
+    return (double) tick.QuadPart * 1000000 / ticksPerSecond.QuadPart;
 }
 
 void zmq_sleep (int seconds_)
@@ -653,14 +765,18 @@ void zmq_sleep (int seconds_)
 
 #else
 
-static uint64_t now ()
+double zmq_clock ()
 {
-    struct timeval tv;
+#if defined CLOCK_MONOTONIC
+    struct timespec ts;
     int rc;
 
-    rc = gettimeofday (&tv, NULL);
-    assert (rc == 0);
-    return (tv.tv_sec * (uint64_t) 1000000 + tv.tv_usec);
+    rc = clock_gettime (CLOCK_MONOTONIC, &ts);
+    errno_assert (rc == 0);
+    return ts.tv_sec * 1000000.0 + ts.tv_nsec / 1000.0;
+#else
+    return (double) zmq::now_us ();
+#endif
 }
 
 void zmq_sleep (int seconds_)
@@ -674,13 +790,13 @@ void *zmq_stopwatch_start ()
 {
     uint64_t *watch = (uint64_t*) malloc (sizeof (uint64_t));
     zmq_assert (watch);
-    *watch = now ();
+    *watch = zmq::now_us ();
     return (void*) watch;
 }
 
 unsigned long zmq_stopwatch_stop (void *watch_)
 {
-    uint64_t end = now ();
+    uint64_t end = zmq::now_us ();
     uint64_t start = *(uint64_t*) watch_;
     free (watch_);
     return (unsigned long) (end - start);
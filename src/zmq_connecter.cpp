@@ -22,7 +22,9 @@
 #include "zmq_connecter.hpp"
 #include "zmq_engine.hpp"
 #include "zmq_init.hpp"
+#include "socket_base.hpp"
 #include "io_thread.hpp"
+#include "config.hpp"
 #include "err.hpp"
 
 zmq::zmq_connecter_t::zmq_connecter_t (io_thread_t *parent_,
@@ -32,6 +34,7 @@ zmq::zmq_connecter_t::zmq_connecter_t (io_thread_t *parent_,
     io_object_t (parent_),
     handle_valid (false),
     wait (wait_),
+    timer (NULL),
     session_ordinal (session_ordinal_),
     options (options_)
 {
@@ -55,7 +58,7 @@ int zmq::zmq_connecter_t::set_address (const char *protocol_,
 void zmq::zmq_connecter_t::process_plug ()
 {
     if (wait)
-        add_timer ();
+        timer = add_timer (reconnect_ivl, 0);
     else
         start_connecting ();
 }
@@ -63,7 +66,7 @@ void zmq::zmq_connecter_t::process_plug ()
 void zmq::zmq_connecter_t::process_unplug ()
 {
     if (wait)
-        cancel_timer ();
+        cancel_timer (timer);
     if (handle_valid)
         rm_fd (handle);
 }
@@ -86,7 +89,7 @@ void zmq::zmq_connecter_t::out_event ()
     if (fd == retired_fd) {
         tcp_connecter.close ();
         wait = true;
-        add_timer ();
+        timer = add_timer (reconnect_ivl, 0);
         return;
     }
 
@@ -103,8 +106,9 @@ void zmq::zmq_connecter_t::out_event ()
     term ();
 }
 
-void zmq::zmq_connecter_t::timer_event ()
+void zmq::zmq_connecter_t::timer_event (int id_)
 {
+    owner->inc_reconnects ();
     wait = false;
     start_connecting ();
 }
@@ -132,5 +136,5 @@ void zmq::zmq_connecter_t::start_connecting ()
 
     //  Handle any other error condition by eventual reconnect.
     wait = true;
-    add_timer ();
+    timer = add_timer (reconnect_ivl, 0);
 }
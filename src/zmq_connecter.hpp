@@ -51,7 +51,7 @@ namespace zmq
         //  Handlers for I/O events.
         void in_event ();
         void out_event ();
-        void timer_event ();
+        void timer_event (int id_);
 
         //  Internal function to start the actual connection establishment.
         void start_connecting ();
@@ -67,7 +67,9 @@ namespace zmq
         bool handle_valid;
 
         //  If true, connecter is waiting a while before trying to connect.
+        //  'timer' holds the handle of the reconnect timer in that case.
         bool wait;
+        timer_handle_t timer;
 
         //  Ordinal of the session to attach to.
         uint64_t session_ordinal;
@@ -23,6 +23,7 @@
 #include "zmq_decoder.hpp"
 #include "i_inout.hpp"
 #include "wire.hpp"
+#include "config.hpp"
 #include "err.hpp"
 
 zmq::zmq_decoder_t::zmq_decoder_t (size_t bufsize_) :
@@ -48,19 +49,15 @@ void zmq::zmq_decoder_t::set_inout (i_inout *destination_)
 bool zmq::zmq_decoder_t::one_byte_size_ready ()
 {
     //  First byte of size is read. If it is 0xff read 8-byte size.
-    //  Otherwise allocate the buffer for message data and read the
-    //  message data into it.
+    //  Otherwise read the flags. The buffer for message data is allocated
+    //  once the flags are read.
     if (*tmpbuf == 0xff)
         next_step (tmpbuf, 8, &zmq_decoder_t::eight_byte_size_ready);
     else {
 
         //  TODO:  Handle over-sized message decently.
 
-        //  in_progress is initialised at this point so in theory we should
-        //  close it before calling zmq_msg_init_size, however, it's a 0-byte
-        //  message and thus we can treat it as uninitialised...
-        int rc = zmq_msg_init_size (&in_progress, *tmpbuf - 1);
-        errno_assert (rc == 0);
+        msg_size = *tmpbuf - 1;
         next_step (tmpbuf, 1, &zmq_decoder_t::flags_ready);
     }
     return true;
@@ -68,17 +65,12 @@ bool zmq::zmq_decoder_t::one_byte_size_ready ()
 
 bool zmq::zmq_decoder_t::eight_byte_size_ready ()
 {
-    //  8-byte size is read. Allocate the buffer for message body and
-    //  read the message data into it.
+    //  8-byte size is read. Read the flags.
     size_t size = (size_t) get_uint64 (tmpbuf);
 
     //  TODO:  Handle over-sized message decently.
 
-    //  in_progress is initialised at this point so in theory we should
-    //  close it before calling zmq_msg_init_size, however, it's a 0-byte
-    //  message and thus we can treat it as uninitialised...
-    int rc = zmq_msg_init_size (&in_progress, size - 1);
-    errno_assert (rc == 0);
+    msg_size = size - 1;
     next_step (tmpbuf, 1, &zmq_decoder_t::flags_ready);
 
     return true;
@@ -86,6 +78,20 @@ bool zmq::zmq_decoder_t::eight_byte_size_ready ()
 
 bool zmq::zmq_decoder_t::flags_ready ()
 {
+    //  Flags are read. If the message body is already present in the receive
+    //  buffer and the message is small enough, it is not copied, rather it
+    //  points directly into the buffer. Otherwise allocate the buffer for
+    //  message body and read the message data into it.
+    //
+    //  in_progress is initialised at this point so in theory we should
+    //  close it before initialising it anew, however, it's a 0-byte
+    //  message and thus we can treat it as uninitialised...
+    if (msg_size <= ZMQ_MAX_VSM_SIZE || msg_size > (size_t) in_slice_max_size ||
+          !slice (&in_progress, msg_size)) {
+        int rc = zmq_msg_init_size (&in_progress, msg_size);
+        errno_assert (rc == 0);
+    }
+
     //  Store the flags from the wire into the message structure.
     in_progress.flags = tmpbuf [0];
 
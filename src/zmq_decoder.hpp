@@ -47,6 +47,7 @@ namespace zmq
 
         struct i_inout *destination;
         unsigned char tmpbuf [8];
+        size_t msg_size;
         ::zmq_msg_t in_progress;
 
         zmq_decoder_t (const zmq_decoder_t&);
@@ -23,7 +23,8 @@
 
 zmq::zmq_encoder_t::zmq_encoder_t (size_t bufsize_) :
     encoder_t <zmq_encoder_t> (bufsize_),
-    source (NULL)
+    source (NULL),
+    retained_count (0)
 {
     zmq_msg_init (&in_progress);
 
@@ -33,6 +34,7 @@ zmq::zmq_encoder_t::zmq_encoder_t (size_t bufsize_) :
 
 zmq::zmq_encoder_t::~zmq_encoder_t ()
 {
+    release ();
     zmq_msg_close (&in_progress);
 }
 
@@ -41,6 +43,24 @@ void zmq::zmq_encoder_t::set_inout (i_inout *source_)
     source = source_;
 }
 
+void zmq::zmq_encoder_t::retain ()
+{
+    //  Body of the message is going to be written directly. Keep the message
+    //  alive till it is written. VSMs are never retained as their data
+    //  would move with the message.
+    zmq_assert (retained_count < out_batch_chunks);
+    zmq_assert (in_progress.content != (void*) ZMQ_VSM);
+    retained [retained_count++] = in_progress;
+    zmq_msg_init (&in_progress);
+}
+
+void zmq::zmq_encoder_t::release ()
+{
+    for (int i = 0; i != retained_count; i++)
+        zmq_msg_close (&retained [i]);
+    retained_count = 0;
+}
+
 bool zmq::zmq_encoder_t::size_ready ()
 {
     //  Write message body into the buffer.
@@ -23,6 +23,7 @@
 #include "../include/zmq.h"
 
 #include "encoder.hpp"
+#include "config.hpp"
 
 namespace zmq
 {
@@ -37,6 +38,10 @@ namespace zmq
 
         void set_inout (struct i_inout *source_);
 
+        //  Functions required by encoder_t::get_chunks.
+        void retain ();
+        void release ();
+
     private:
 
         bool size_ready ();
@@ -46,6 +51,10 @@ namespace zmq
         ::zmq_msg_t in_progress;
         unsigned char tmpbuf [10];
 
+        //  Messages whose bodies are being written directly.
+        ::zmq_msg_t retained [out_batch_chunks];
+        int retained_count;
+
         zmq_encoder_t (const zmq_encoder_t&);
         void operator = (const zmq_encoder_t&);
     };
@@ -34,10 +34,10 @@ zmq::zmq_engine_t::zmq_engine_t (io_thread_t *parent_, fd_t fd_,
     io_object_t (parent_),
     inpos (NULL),
     insize (0),
-    decoder (in_batch_size),
-    outpos (NULL),
-    outsize (0),
-    encoder (out_batch_size),
+    decoder ((size_t) options_.in_batch_size),
+    outcount (0),
+    outpos (0),
+    encoder ((size_t) options_.out_batch_size),
     inout (NULL),
     options (options_),
     reconnect (reconnect_)
@@ -124,22 +124,30 @@ void zmq::zmq_engine_t::in_event ()
 
 void zmq::zmq_engine_t::out_event ()
 {
-    //  If write buffer is empty, try to read new data from the encoder.
-    if (!outsize) {
+    //  If all the data were written, try to read new data from the encoder.
+    //  Small messages are copied into the encoder's buffer, larger ones
+    //  are written directly from the message.
+    if (outpos == outcount) {
+
+        outcount = out_batch_chunks;
+        encoder.get_chunks (outchunks, &outcount, out_copy_max_size);
+        outpos = 0;
 
-        outpos = NULL;
-        encoder.get_data (&outpos, &outsize);
-        
         //  If there is no data to send, stop polling for output.
-        if (outsize == 0) {
+        if (outcount == 0) {
             reset_pollout (handle);
             return;
         }
     }
 
-    //  If there are any data to write in write buffer, write as much as
-    //  possible to the socket.
-    int nbytes = tcp_socket.write (outpos, outsize);
+    //  If there are any data to write, write as much as possible to
+    //  the socket.
+    int nbytes;
+    if (outcount - outpos == 1)
+        nbytes = tcp_socket.write (outchunks [outpos].data,
+            outchunks [outpos].size);
+    else
+        nbytes = tcp_socket.write (outchunks + outpos, outcount - outpos);
 
     //  Handle problems with the connection.
     if (nbytes == -1) {
@@ -147,8 +155,19 @@ void zmq::zmq_engine_t::out_event ()
         return;
     }
 
-    outpos += nbytes;
-    outsize -= nbytes;
+    //  Skip the data that were written. Partially written chunk is adjusted
+    //  so that the next write starts where this one finished.
+    size_t written = nbytes;
+    while (written) {
+        chunk_t &chunk = outchunks [outpos];
+        if (written < chunk.size) {
+            chunk.data += written;
+            chunk.size -= written;
+            break;
+        }
+        written -= chunk.size;
+        outpos++;
+    }
 }
 
 void zmq::zmq_engine_t::revive ()
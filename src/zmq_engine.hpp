@@ -30,6 +30,7 @@
 #include "zmq_encoder.hpp"
 #include "zmq_decoder.hpp"
 #include "options.hpp"
+#include "config.hpp"
 
 namespace zmq
 {
@@ -65,8 +66,10 @@ namespace zmq
         size_t insize;
         zmq_decoder_t decoder;
 
-        unsigned char *outpos;
-        size_t outsize;
+        //  Chunks of data to write and the first chunk not yet written.
+        chunk_t outchunks [out_batch_chunks];
+        int outcount;
+        int outpos;
         zmq_encoder_t encoder;
 
         i_inout *inout;
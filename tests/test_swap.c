@@ -0,0 +1,97 @@
+/*
+    Copyright (c) 2007-2010 iMatix Corporation
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the Lesser GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    Lesser GNU General Public License for more details.
+
+    You should have received a copy of the Lesser GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "../include/zmq.h"
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+
+//  Checks that messages are delivered to a receiver with small high water
+//  mark and a swap, even though the writer switches to the swapping mode
+//  in the middle of the batch of messages received from the network.
+
+#define MESSAGE_COUNT 200
+#define MESSAGE_SIZE 8
+
+int main (int argc, char *argv [])
+{
+    void *ctx;
+    void *rcv;
+    void *snd;
+    int rc;
+    int i;
+    uint64_t hwm;
+    int64_t swap;
+    zmq_msg_t msg;
+
+    //  Fail rather than block forever if the messages get stuck.
+    alarm (30);
+
+    ctx = zmq_init (1, 1, 0);
+    assert (ctx);
+
+    rcv = zmq_socket (ctx, ZMQ_UPSTREAM);
+    assert (rcv);
+    hwm = 10;
+    rc = zmq_setsockopt (rcv, ZMQ_HWM, &hwm, sizeof (hwm));
+    assert (rc == 0);
+    swap = 1000000;
+    rc = zmq_setsockopt (rcv, ZMQ_SWAP, &swap, sizeof (swap));
+    assert (rc == 0);
+    rc = zmq_bind (rcv, "tcp://127.0.0.1:5560");
+    assert (rc == 0);
+
+    snd = zmq_socket (ctx, ZMQ_DOWNSTREAM);
+    assert (snd);
+    rc = zmq_connect (snd, "tcp://127.0.0.1:5560");
+    assert (rc == 0);
+
+    for (i = 0; i != MESSAGE_COUNT; i++) {
+        rc = zmq_msg_init_size (&msg, MESSAGE_SIZE);
+        assert (rc == 0);
+        memset (zmq_msg_data (&msg), i % 256, MESSAGE_SIZE);
+        rc = zmq_send (snd, &msg, 0);
+        assert (rc == 0);
+        rc = zmq_msg_close (&msg);
+        assert (rc == 0);
+    }
+
+    for (i = 0; i != MESSAGE_COUNT; i++) {
+        rc = zmq_msg_init (&msg);
+        assert (rc == 0);
+        rc = zmq_recv (rcv, &msg, 0);
+        assert (rc == 0);
+        assert (zmq_msg_size (&msg) == MESSAGE_SIZE);
+        assert (((unsigned char*) zmq_msg_data (&msg)) [0] == i % 256);
+        rc = zmq_msg_close (&msg);
+        assert (rc == 0);
+    }
+
+    rc = zmq_close (snd);
+    assert (rc == 0);
+    rc = zmq_close (rcv);
+    assert (rc == 0);
+    rc = zmq_term (ctx);
+    assert (rc == 0);
+
+    return 0;
+}